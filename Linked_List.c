@@ -27,12 +27,82 @@
 #undef NULL
 #define NULL List_nullptr
 
-#ifdef LIST_THREAD_SAFED
-#define List_Lock(list)   List_MutexAcquire(list->lock)
-#define List_UnLock(list) List_MutexRelease(list->lock)
+// the number of bins for merge sort, enough for 2^32 nodes
+#define _SORT_BINS 33
+
+// the max depth of the run stack for natural sort, enough for 2^32 nodes
+#define _SORT_MAX_RUNS 64
+
+// switch to galloping mode after taking so many nodes from one side
+#define _SORT_MIN_GALLOP 7
+
+// use insertion sort for the small parts in array sort
+#define _SORT_ARRAY_THRESHOLD 16
+
+// radix sort digit size (in bits)
+#define _RADIX_BITS    8
+#define _RADIX_BUCKETS (1 << _RADIX_BITS)
+#define _RADIX_PASSES  ((64 + _RADIX_BITS - 1) / _RADIX_BITS)
+
+// parallel sort limits
+#define _PARALLEL_MAX_THREADS 64
+#define _PARALLEL_MIN_SEGMENT 4096
+
+#if defined(LIST_THREAD_SAFED) && defined(LIST_RWLOCK)
+#define List_LockNew()           List_RwLockNew()
+#define List_LockFree(lock)      List_RwLockFree(lock)
+#define List_Lock(list)          List_RwLockAcquireExclusive(list->lock)
+#define List_UnLock(list)        List_RwLockReleaseExclusive(list->lock)
+#define List_LockShared(list)    List_RwLockAcquireShared(list->lock)
+#define List_UnLockShared(list)  List_RwLockReleaseShared(list->lock)
+#define List_PoolLock(pool)      List_RwLockAcquireExclusive(pool->lock)
+#define List_PoolUnLock(pool)    List_RwLockReleaseExclusive(pool->lock)
+#elif defined(LIST_THREAD_SAFED)
+#define List_LockNew()           List_MutexNew()
+#define List_LockFree(lock)      List_MutexFree(lock)
+#define List_Lock(list)          List_MutexAcquire(list->lock)
+#define List_UnLock(list)        List_MutexRelease(list->lock)
+#define List_LockShared(list)    List_MutexAcquire(list->lock)
+#define List_UnLockShared(list)  List_MutexRelease(list->lock)
+#define List_PoolLock(pool)      List_MutexAcquire(pool->lock)
+#define List_PoolUnLock(pool)    List_MutexRelease(pool->lock)
 #else
 #define List_Lock(list)
 #define List_UnLock(list)
+#define List_LockShared(list)
+#define List_UnLockShared(list)
+#define List_PoolLock(pool)
+#define List_PoolUnLock(pool)
+#endif
+
+// the 'head', 'tail' and 'length' of a list are published by atomic stores,
+// so 'List_Length', 'List_IsEmpty', 'List_First', 'List_Last' can read them without lock
+#ifdef List_AtomicLoad
+#define _list_load(field)       List_AtomicLoad(&(field))
+#define _list_store(field, val) List_AtomicStore(&(field), (val))
+#define List_LockField(list)
+#define List_UnLockField(list)
+#else
+#define _list_load(field)       (field)
+#define _list_store(field, val) ((field) = (val))
+#define List_LockField(list)    List_LockShared(list)
+#define List_UnLockField(list)  List_UnLockShared(list)
+#endif
+
+// in epoch mode, the 'next' links are followed by the lock-free readers
+#ifdef LIST_EPOCH_RECLAIM
+#define _link_load(field)       __atomic_load_n(&(field), __ATOMIC_ACQUIRE)
+#define _link_store(field, val) __atomic_store_n(&(field), (val), __ATOMIC_RELEASE)
+#else
+#define _link_load(field)       (field)
+#define _link_store(field, val) ((field) = (val))
+#endif
+
+#ifdef LIST_EPOCH_RECLAIM
+// a reader slot is packed as: (epoch << _EPOCH_COUNT_BITS) | reader count
+#define _EPOCH_COUNT_BITS 12
+#define _EPOCH_COUNT_MASK ((1u << _EPOCH_COUNT_BITS) - 1)
+#define _EPOCH_MASK       (0xFFFFFFFFu >> _EPOCH_COUNT_BITS)
 #endif
 
 struct List_t {
@@ -40,6 +110,101 @@ struct List_t {
     ListNode_t *tail;
     uint32_t length;
     ListDataDestructor_t destructor;
+    ListNodePool_t *pool;
+    bool own_pool;
+    bool intrusive;
+    struct _hash_index *index;
+    struct _pos_index *positions;
+    struct _heap_index *heap;
+    ListNodeComparer_t pq_comparer; // the comparer of priority index, it's kept when the index is dropped
+#ifdef LIST_THREAD_SAFED
+    void *lock;
+#endif
+#ifdef LIST_BLOCKING_QUEUE
+    void *not_empty;
+    void *not_full;
+    uint32_t capacity;
+    uint32_t consumers; // the number of waiting consumers
+    uint32_t producers; // the number of waiting producers
+    bool closed;
+#endif
+#ifdef LIST_EPOCH_RECLAIM
+    uint32_t epoch;
+    uint32_t readers[LIST_EPOCH_READERS];
+    ListNode_t *limbo[3]; // the removed nodes of the last 3 epochs, linked by 'prev'
+    uint32_t limbo_pos;   // the limbo of current epoch
+    uint32_t excluders;   // the number of writers which keep the lock-free readers out
+#endif
+};
+
+struct _node_slab {
+    struct _node_slab *next;
+    ListNode_t nodes[];
+};
+
+typedef struct {
+    uint32_t hash;
+    ListNode_t *node; // NULL: empty slot
+} _index_slot;
+
+struct _hash_index {
+    _index_slot *slots;
+    uint32_t shift; // capacity == 2^(32 - shift)
+    uint32_t count;
+    ListDataHasher_t hasher;
+    ListNodeComparer_t comparer;
+};
+
+// an entry of the position index (a treap ordered by the list order, with subtree sizes)
+struct _pos_entry {
+    struct _pos_entry *left;
+    struct _pos_entry *right;
+    struct _pos_entry *parent;
+    ListNode_t *node;
+    uint32_t size;
+    uint32_t prio;
+};
+
+typedef struct {
+    ListNode_t *node; // NULL: empty slot
+    void *entry;
+} _map_slot;
+
+// an open addressing map: node -> entry, for the position index and the priority index
+struct _node_map {
+    _map_slot *slots;
+    uint32_t shift; // capacity == 2^(32 - shift)
+    uint32_t count;
+};
+
+struct _pos_index {
+    struct _pos_entry *root;
+    struct _node_map map; // node -> entry
+    uint32_t seed;
+};
+
+// an entry of the priority index
+struct _heap_entry {
+    ListNode_t *node;
+    uint32_t pos; // the position in the heap array
+};
+
+// the priority index (a binary min-heap of the nodes, ordered by the comparer)
+struct _heap_index {
+    struct _heap_entry **heap;
+    uint32_t count;
+    uint32_t capacity;
+    struct _node_map map; // node -> entry
+    ListNodeComparer_t comparer;
+};
+
+struct ListNodePool_t {
+    struct _node_slab *slabs;
+    ListNode_t *free_nodes;
+    ListNode_t *bump;
+    ListNode_t *bump_end;
+    uint32_t chunk_size;
+    uint32_t owners; // the number of lists which own this private pool
 #ifdef LIST_THREAD_SAFED
     void *lock;
 #endif
@@ -49,596 +214,3788 @@ struct List_t {
 
 static List_Inline void _cut_prev(ListNode_t *node)
 {
-    node->prev->next = NULL;
-    node->prev       = NULL;
+    _link_store(node->prev->next, NULL);
+    node->prev = NULL;
 }
 
+// in epoch mode, the removed node keeps its 'next' link,
+// so the readers standing on it can go on
 static List_Inline void _cut_next(ListNode_t *node)
 {
     node->next->prev = NULL;
-    node->next       = NULL;
+#ifndef LIST_EPOCH_RECLAIM
+    node->next = NULL;
+#endif
 }
 
 static List_Inline void _link_next(ListNode_t *node, ListNode_t *nNode)
 {
     ListNode_t *next;
 
+    nNode->prev = node;
+
     if (node->next == NULL) {
-        node->next  = nNode;
-        nNode->prev = node;
+        _link_store(node->next, nNode);
     } else {
-        next = node->next;
-        _cut_next(node);
-        node->next  = nNode;
-        nNode->prev = node;
+        next        = node->next;
         nNode->next = next;
         next->prev  = nNode;
+        _link_store(node->next, nNode);
     }
 }
 
-static List_Inline void _swap_node(ListNode_t *n1, ListNode_t *n2)
+static void _null_data_destructor(void *nul)
 {
-    void *data1 = n1->data;
-    n1->data    = n2->data;
-    n2->data    = data1;
+    /* nothing todo */
 }
 
-static List_Inline void _set_node(ListNode_t *node, void *data)
-{
-    node->data = data;
-}
+//----------------------------- node alloc -----------------------------------
 
-static void _null_data_destructor(void *nul)
+// add a new slab, the caller must hold the pool lock
+static void _pool_grow(ListNodePool_t *pool)
 {
-    /* nothing todo */
+    struct _node_slab *slab;
+
+    slab = (struct _node_slab *)List_mem_alloc(sizeof(struct _node_slab) +
+                                               pool->chunk_size * sizeof(ListNode_t));
+    slab->next     = pool->slabs;
+    pool->slabs    = slab;
+    pool->bump     = slab->nodes;
+    pool->bump_end = slab->nodes + pool->chunk_size;
+
+    // the next slab is twice larger, so a big pool has only a few slabs to release
+    if (pool->chunk_size < LIST_NODE_POOL_MAX_CHUNK_SIZE) {
+        pool->chunk_size *= 2;
+        if (pool->chunk_size > LIST_NODE_POOL_MAX_CHUNK_SIZE) {
+            pool->chunk_size = LIST_NODE_POOL_MAX_CHUNK_SIZE;
+        }
+    }
 }
 
-static ListNode_t *_list_pop(List_t *list)
+static ListNode_t *_pool_alloc(ListNodePool_t *pool)
 {
-    ListNode_t *node = NULL;
+    ListNode_t *node;
 
-    if (list->length == 0) {
-        return node;
-    }
+    List_PoolLock(pool);
+    {
+        if (pool->free_nodes != NULL) {
+            node             = pool->free_nodes;
+            pool->free_nodes = node->next;
+        } else {
 
-    if (list->head == list->tail) {
-        node         = list->head;
-        list->head   = NULL;
-        list->tail   = NULL;
-        list->length = 0;
-    } else {
-        node       = list->tail;
-        list->tail = node->prev;
-        _cut_prev(node);
-        list->length--;
+            if (pool->bump == pool->bump_end) {
+                _pool_grow(pool);
+            }
+
+            node = pool->bump++;
+        }
     }
+    List_PoolUnLock(pool);
 
     return node;
 }
 
-static ListNode_t *_list_remove_node(List_t *list, ListNode_t *node)
+// take n nodes in one step, return a chain linked by 'next'
+static ListNode_t *_pool_alloc_chain(ListNodePool_t *pool, uint32_t n)
 {
-    ListNode_t *prev, *next;
-
-    if (list->length == 0) {
-        return NULL;
-    }
+    ListNode_t *first = NULL, *node;
 
-    if (node == list->head) {
-        if (node->next != NULL) {
-            list->head = node->next;
-            _cut_next(node);
-        } else {
-            list->head = list->tail = NULL;
+    List_PoolLock(pool);
+    {
+        while (n > 0 && pool->free_nodes != NULL) {
+            node             = pool->free_nodes;
+            pool->free_nodes = node->next;
+            node->next       = first;
+            first            = node;
+            n--;
         }
-    }
 
-    else if (node == list->tail) {
-        if (node->prev != NULL) {
-            list->tail = node->prev;
-            _cut_prev(node);
-        } else {
-            list->head = list->tail = NULL;
-        }
-    }
+        while (n > 0) {
 
-    else if (node->prev == NULL || node->next == NULL) {
-        return NULL; // invalid node, skip
-    }
+            if (pool->bump == pool->bump_end) {
+                _pool_grow(pool);
+            }
 
-    else {
-        prev = node->prev;
-        next = node->next;
-        _cut_prev(node);
-        _cut_next(node);
-        prev->next = next;
-        next->prev = prev;
+            node       = pool->bump++;
+            node->next = first;
+            first      = node;
+            n--;
+        }
     }
+    List_PoolUnLock(pool);
 
-    list->length--;
+    return first;
+}
 
-    return node;
+// give back a chain of nodes (linked by 'next') in one step
+static void _pool_free_chain(ListNodePool_t *pool, ListNode_t *first, ListNode_t *last)
+{
+    List_PoolLock(pool);
+    last->next       = pool->free_nodes;
+    pool->free_nodes = first;
+    List_PoolUnLock(pool);
 }
 
-static ListNode_t *_list_find_first(List_t *list, ListNodeMatcher_t matcher, void *params)
+static List_Inline ListNode_t *_node_new(List_t *list, void *data)
 {
-    ListNode_t *node = list->head;
+    ListNode_t *node;
 
-    while (node != NULL) {
-        if (matcher(node->data, params)) break;
-        node = node->next;
+    if (list->pool != NULL) {
+        node = _pool_alloc(list->pool);
+    } else {
+        node = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
     }
 
+    node->data = data;
+    node->next = NULL;
+    node->prev = NULL;
+
     return node;
 }
 
-//-------------------------------------------------------
-
-List_t *List_CreateList(ListDataDestructor_t destructor)
+// create n nodes for 'data[0..n-1]' and link them in order, n must > 0
+static ListNode_t *_chain_new(List_t *list, void **data, uint32_t n, ListNode_t **last)
 {
-    List_t *list = (List_t *)List_mem_alloc(sizeof(List_t));
+    ListNode_t *first, *node, *prev = NULL;
+    uint32_t i;
 
-    list->length     = 0;
-    list->head       = NULL;
-    list->tail       = NULL;
-    list->destructor = destructor == NULL ? _null_data_destructor : destructor;
+    if (list->pool != NULL) {
+        first = _pool_alloc_chain(list->pool, n);
+    } else {
+        // the nodes are freed one by one, so they can't share one memory block
+        first = NULL;
+        for (i = 0; i < n; i++) {
+            node       = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
+            node->next = first;
+            first      = node;
+        }
+    }
 
-#ifdef LIST_THREAD_SAFED
-    list->lock = List_MutexNew();
-#endif
+    for (i = 0, node = first; i < n; i++, node = node->next) {
+        node->data = data[i];
+        node->prev = prev;
+        prev       = node;
+    }
 
-    return list;
-}
+    prev->next = NULL;
+    *last      = prev;
 
-void List_DestroyList(List_t *list)
-{
-    List_Clear(list);
-#ifdef LIST_THREAD_SAFED
-    List_MutexFree(list->lock);
-#endif
-    List_mem_free(list);
+    return first;
 }
 
-void List_Clear(List_t *list)
+static List_Inline void _node_free(List_t *list, ListNode_t *node)
 {
-    ListNode_t *node;
-
-    List_Lock(list);
-    {
-        node = _list_pop(list);
-
-        while (node != NULL) {
-            list->destructor(node->data);
-            List_mem_free(node);
-            node = _list_pop(list);
-        }
+    if (list->intrusive) {
+        // the node is owned by user data, nothing todo
+    } else if (list->pool != NULL) {
+        _pool_free_chain(list->pool, node, node);
+    } else {
+        List_mem_free(node);
     }
-    List_UnLock(list);
 }
 
-ListNode_t *List_Pop(List_t *list)
+//----------------------------- hash index -----------------------------------
+
+// fibonacci hashing, use the high bits of the product as slot position
+static List_Inline uint32_t _index_pos(struct _hash_index *index, uint32_t hash)
 {
-    ListNode_t *node;
-    List_Lock(list);
-    node = _list_pop(list);
-    List_UnLock(list);
-    return node;
+    return (uint32_t)(hash * 2654435769u) >> index->shift;
 }
 
-ListNode_t *List_Push(List_t *list, void *data)
+static List_Inline uint32_t _index_mask(struct _hash_index *index)
 {
-    ListNode_t *node;
-
-    node = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
-
-    node->data = data;
-    node->next = NULL;
-    node->prev = NULL;
+    return (uint32_t)(0xFFFFFFFFu >> index->shift);
+}
 
-    List_Lock(list);
-    {
-        if (list->length == 0) {
-            list->head = list->tail = node;
-        } else {
-            list->tail->next = node;
-            node->prev       = list->tail;
-            list->tail       = node;
-        }
+static void _index_put(struct _hash_index *index, uint32_t hash, ListNode_t *node)
+{
+    uint32_t pos = _index_pos(index, hash), mask = _index_mask(index);
 
-        list->length++;
+    while (index->slots[pos].node != NULL) {
+        pos = (pos + 1) & mask;
     }
-    List_UnLock(list);
 
-    return node;
+    index->slots[pos].hash = hash;
+    index->slots[pos].node = node;
+    index->count++;
 }
 
-ListNode_t *List_Prepend(List_t *list, void *data)
+static bool _index_resize(struct _hash_index *index, uint32_t shift)
 {
-    ListNode_t *node;
+    _index_slot *old = index->slots;
+    uint32_t i, oldCap = old == NULL ? 0 : _index_mask(index) + 1;
+    uint32_t cap = (uint32_t)(0xFFFFFFFFu >> shift) + 1;
 
-    node = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
+    index->slots = (_index_slot *)List_mem_alloc(cap * sizeof(_index_slot));
 
-    node->data = data;
-    node->next = NULL;
-    node->prev = NULL;
+    if (index->slots == NULL) {
+        index->slots = old;
+        return false;
+    }
 
-    List_Lock(list);
-    {
-        if (list->length == 0) {
-            list->head = list->tail = node;
-        } else {
-            node->next       = list->head;
-            list->head->prev = node;
-            list->head       = node;
+    for (i = 0; i < cap; i++) {
+        index->slots[i].node = NULL;
+    }
+
+    index->shift = shift;
+    index->count = 0;
+
+    for (i = 0; i < oldCap; i++) {
+        if (old[i].node != NULL) {
+            _index_put(index, old[i].hash, old[i].node);
         }
+    }
 
-        list->length++;
+    if (old != NULL) {
+        List_mem_free(old);
     }
-    List_UnLock(list);
 
-    return node;
+    return true;
 }
 
-ListNode_t *List_Dequeue(List_t *list)
+static bool _index_add(struct _hash_index *index, ListNode_t *node)
 {
-    ListNode_t *node = NULL;
-
-    List_Lock(list);
-    {
-        if (list->length == 0) {
-            List_UnLock(list);
-            return node;
-        }
-
-        if (list->head == list->tail) {
-            node         = list->head;
-            list->head   = NULL;
-            list->tail   = NULL;
-            list->length = 0;
-        } else {
-            node       = list->head;
-            list->head = node->next;
-            _cut_next(node);
-            list->length--;
-        }
+    // keep load factor <= 0.75, a full table would make '_index_put' probe forever
+    if ((index->count + 1) * 4 > (_index_mask(index) + 1) * 3) {
+        if (!_index_resize(index, index->shift - 1)) return false;
     }
-    List_UnLock(list);
 
-    return node;
+    _index_put(index, index->hasher(node->data), node);
+
+    return true;
 }
 
-ListNode_t *List_Enqueue(List_t *list, void *data)
+static void _index_free(struct _hash_index *index)
 {
-    return List_Push(list, data);
+    List_mem_free(index->slots);
+    List_mem_free(index);
 }
 
-ListNode_t *List_FindFirst(List_t *list, ListNodeMatcher_t matcher, void *params)
+// the hash index is dropped if we are out of memory, same as the position index
+static void _index_link(List_t *list, ListNode_t *node)
 {
-    ListNode_t *node;
-    List_Lock(list);
-    node = _list_find_first(list, matcher, params);
-    List_UnLock(list);
-    return node;
+    if (!_index_add(list->index, node)) {
+        _index_free(list->index);
+        list->index = NULL;
+    }
 }
 
-ListNode_t *List_FindNext(List_t *list, ListNode_t *node,
-                          ListNodeMatcher_t matcher, void *params)
+static void _index_remove(struct _hash_index *index, ListNode_t *node)
 {
-    ListNode_t *cNode;
+    uint32_t mask = _index_mask(index), pos, next, home;
 
-    List_Lock(list);
-    {
-        cNode = node->next;
+    pos = _index_pos(index, index->hasher(node->data));
 
-        while (cNode != NULL) {
-            if (matcher(cNode->data, params)) break;
-            cNode = cNode->next;
+    while (index->slots[pos].node != node) {
+        if (index->slots[pos].node == NULL) return; // not found
+        pos = (pos + 1) & mask;
+    }
+
+    // backward shift the following slots, so we don't need tombstones
+    next = (pos + 1) & mask;
+
+    while (index->slots[next].node != NULL) {
+
+        home = _index_pos(index, index->slots[next].hash);
+
+        // move it if its home position is not in (pos, next]
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            index->slots[pos] = index->slots[next];
+            pos               = next;
         }
+
+        next = (next + 1) & mask;
     }
-    List_UnLock(list);
 
-    return cNode;
+    index->slots[pos].node = NULL;
+    index->count--;
 }
 
-ListNode_t *List_First(List_t *list)
+static void _index_rebuild(List_t *list)
 {
+    struct _hash_index *index = list->index;
     ListNode_t *node;
-    List_Lock(list);
-    node = list->head;
-    List_UnLock(list);
-    return node;
+    uint32_t i, mask = _index_mask(index);
+
+    for (i = 0; i <= mask; i++) {
+        index->slots[i].node = NULL;
+    }
+
+    index->count = 0;
+
+    for (node = list->head; node != NULL && list->index != NULL; node = node->next) {
+        _index_link(list, node);
+    }
 }
 
-ListNode_t *List_Last(List_t *list)
+static ListNode_t *_index_find(struct _hash_index *index, void *key)
 {
-    ListNode_t *node;
-    List_Lock(list);
-    node = list->tail;
-    List_UnLock(list);
-    return node;
+    uint32_t hash = index->hasher(key), mask = _index_mask(index);
+    uint32_t pos  = _index_pos(index, hash);
+
+    while (index->slots[pos].node != NULL) {
+
+        if (index->slots[pos].hash == hash &&
+            index->comparer(index->slots[pos].node->data, key) == 0) {
+            return index->slots[pos].node;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+
+    return NULL;
 }
 
-uint32_t List_Length(List_t *list)
+//----------------------------- node map -----------------------------------
+
+static List_Inline uint32_t _map_hash(struct _node_map *map, ListNode_t *node)
 {
-    uint32_t len;
-    List_Lock(list);
-    len = list->length;
-    List_UnLock(list);
-    return len;
+    return (uint32_t)(((uintptr_t)node >> 3) * 2654435769u) >> map->shift;
 }
 
-ListNode_t *List_InsertNode(List_t *list, ListNode_t *node, void *data)
+static List_Inline uint32_t _map_mask(struct _node_map *map)
 {
-    ListNode_t *nNode;
+    return (uint32_t)(0xFFFFFFFFu >> map->shift);
+}
 
-    nNode       = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
-    nNode->prev = NULL;
-    nNode->next = NULL;
-    nNode->data = data;
+static void _map_put(struct _node_map *map, ListNode_t *node, void *entry)
+{
+    uint32_t pos = _map_hash(map, node), mask = _map_mask(map);
 
-    List_Lock(list);
-    {
-        _link_next(node, nNode);
-        if (node == list->tail) list->tail = nNode;
-        list->length++;
+    while (map->slots[pos].node != NULL) {
+        pos = (pos + 1) & mask;
     }
-    List_UnLock(list);
 
-    return nNode;
+    map->slots[pos].node  = node;
+    map->slots[pos].entry = entry;
+    map->count++;
 }
 
-ListNode_t *List_InsertNodeBefore(List_t *list, ListNode_t *node, void *data)
+static bool _map_resize(struct _node_map *map, uint32_t shift)
 {
-    ListNode_t *nNode;
+    _map_slot *old = map->slots;
+    uint32_t i, oldCap = old == NULL ? 0 : _map_mask(map) + 1;
+    uint32_t cap = (uint32_t)(0xFFFFFFFFu >> shift) + 1;
 
-    nNode       = (ListNode_t *)List_mem_alloc(sizeof(ListNode_t));
-    nNode->prev = NULL;
-    nNode->next = NULL;
-    nNode->data = data;
+    map->slots = (_map_slot *)List_mem_alloc(cap * sizeof(_map_slot));
 
-    List_Lock(list);
-    {
-        if (node == list->head) {
-            list->head       = nNode;
-            list->head->next = node;
-            node->prev       = list->head;
-        } else {
-            _link_next(node->prev, nNode);
-        }
+    if (map->slots == NULL) {
+        map->slots = old;
+        return false;
+    }
 
-        list->length++;
+    for (i = 0; i < cap; i++) {
+        map->slots[i].node = NULL;
     }
-    List_UnLock(list);
 
-    return nNode;
+    map->shift = shift;
+    map->count = 0;
+
+    for (i = 0; i < oldCap; i++) {
+        if (old[i].node != NULL) {
+            _map_put(map, old[i].node, old[i].entry);
+        }
+    }
+
+    if (old != NULL) {
+        List_mem_free(old);
+    }
+
+    return true;
+}
+
+// make room for one more node, keep load factor <= 0.75
+static List_Inline bool _map_reserve(struct _node_map *map)
+{
+    if ((map->count + 1) * 4 > (_map_mask(map) + 1) * 3) {
+        return _map_resize(map, map->shift - 1);
+    }
+
+    return true;
+}
+
+static void *_map_find(struct _node_map *map, ListNode_t *node)
+{
+    uint32_t pos = _map_hash(map, node), mask = _map_mask(map);
+
+    while (map->slots[pos].node != NULL) {
+        if (map->slots[pos].node == node) return map->slots[pos].entry;
+        pos = (pos + 1) & mask;
+    }
+
+    return NULL;
+}
+
+static void _map_remove(struct _node_map *map, ListNode_t *node)
+{
+    uint32_t mask = _map_mask(map), pos, next, home;
+
+    pos = _map_hash(map, node);
+
+    while (map->slots[pos].node != node) {
+        if (map->slots[pos].node == NULL) return; // not found
+        pos = (pos + 1) & mask;
+    }
+
+    // backward shift, same as '_index_remove'
+    next = (pos + 1) & mask;
+
+    while (map->slots[next].node != NULL) {
+
+        home = _map_hash(map, map->slots[next].node);
+
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            map->slots[pos] = map->slots[next];
+            pos             = next;
+        }
+
+        next = (next + 1) & mask;
+    }
+
+    map->slots[pos].node = NULL;
+    map->count--;
+}
+
+//----------------------------- position index -----------------------------------
+
+static List_Inline uint32_t _pos_size(struct _pos_entry *e)
+{
+    return e == NULL ? 0 : e->size;
+}
+
+static List_Inline uint32_t _pos_random(struct _pos_index *pi)
+{
+    // xorshift32
+    pi->seed ^= pi->seed << 13;
+    pi->seed ^= pi->seed >> 17;
+    pi->seed ^= pi->seed << 5;
+    return pi->seed;
+}
+
+// rotate 'e' up over its parent, keep the subtree sizes
+static void _pos_rotate_up(struct _pos_index *pi, struct _pos_entry *e)
+{
+    struct _pos_entry *p = e->parent, *g = p->parent, *child;
+
+    if (p->left == e) {
+        child    = e->right;
+        p->left  = child;
+        e->right = p;
+    } else {
+        child    = e->left;
+        p->right = child;
+        e->left  = p;
+    }
+
+    if (child != NULL) child->parent = p;
+
+    p->parent = e;
+    e->parent = g;
+
+    if (g == NULL) {
+        pi->root = e;
+    } else if (g->left == p) {
+        g->left = e;
+    } else {
+        g->right = e;
+    }
+
+    p->size = _pos_size(p->left) + _pos_size(p->right) + 1;
+    e->size = _pos_size(e->left) + _pos_size(e->right) + 1;
+}
+
+// insert a node after the node of 'prev' (if 'prev' is NULL, insert it at front)
+static bool _pos_insert(struct _pos_index *pi, struct _pos_entry *prev, ListNode_t *node)
+{
+    struct _pos_entry *e, *p;
+
+    if (!_map_reserve(&pi->map)) {
+        return false;
+    }
+
+    e = (struct _pos_entry *)List_mem_alloc(sizeof(struct _pos_entry));
+
+    if (e == NULL) {
+        return false;
+    }
+
+    e->left  = NULL;
+    e->right = NULL;
+    e->node  = node;
+    e->size  = 1;
+    e->prio  = _pos_random(pi);
+
+    // the successor of 'prev' is the leftmost one of its right subtree
+    if (pi->root == NULL) {
+        e->parent = NULL;
+        pi->root  = e;
+    } else {
+
+        if (prev == NULL) {
+            p = pi->root;
+        } else if (prev->right == NULL) {
+            p           = prev;
+            p->right    = e;
+            e->parent   = p;
+            p           = NULL;
+        } else {
+            p = prev->right;
+        }
+
+        if (p != NULL) {
+            while (p->left != NULL) p = p->left;
+            p->left   = e;
+            e->parent = p;
+        }
+
+        for (p = e->parent; p != NULL; p = p->parent) {
+            p->size++;
+        }
+
+        while (e->parent != NULL && e->parent->prio < e->prio) {
+            _pos_rotate_up(pi, e);
+        }
+    }
+
+    _map_put(&pi->map, node, e);
+
+    return true;
+}
+
+static void _pos_remove(struct _pos_index *pi, ListNode_t *node)
+{
+    struct _pos_entry *e = _map_find(&pi->map, node), *child, *p;
+
+    if (e == NULL) {
+        return;
+    }
+
+    // rotate it down until it has only one child
+    while (e->left != NULL && e->right != NULL) {
+        _pos_rotate_up(pi, e->left->prio > e->right->prio ? e->left : e->right);
+    }
+
+    child = e->left != NULL ? e->left : e->right;
+    p     = e->parent;
+
+    if (child != NULL) child->parent = p;
+
+    if (p == NULL) {
+        pi->root = child;
+    } else if (p->left == e) {
+        p->left = child;
+    } else {
+        p->right = child;
+    }
+
+    for (; p != NULL; p = p->parent) {
+        p->size--;
+    }
+
+    _map_remove(&pi->map, node);
+    List_mem_free(e);
+}
+
+static void _pos_clear(struct _pos_index *pi)
+{
+    uint32_t i, mask = _map_mask(&pi->map);
+
+    for (i = 0; i <= mask; i++) {
+        if (pi->map.slots[i].node != NULL) {
+            List_mem_free(pi->map.slots[i].entry);
+            pi->map.slots[i].node = NULL;
+        }
+    }
+
+    pi->root      = NULL;
+    pi->map.count = 0;
+}
+
+// build the treap from the list in O(n), like building a cartesian tree with a stack,
+// the right spine of the tree is the stack;
+// if 'reuse' is true, the nodes are not changed (only reordered), reuse the entries in the map
+static bool _pos_build(struct _pos_index *pi, List_t *list, bool reuse)
+{
+    struct _pos_entry *e, *last = NULL, *x, *popped;
+    ListNode_t *node;
+    uint32_t i;
+
+    pi->root = NULL;
+
+    for (i = 0, node = list->head; node != NULL; i++, node = node->next) {
+
+        if (reuse) {
+            e = _map_find(&pi->map, node);
+        } else {
+
+            if (!_map_reserve(&pi->map)) {
+                return false;
+            }
+
+            e = (struct _pos_entry *)List_mem_alloc(sizeof(struct _pos_entry));
+
+            if (e == NULL) {
+                return false;
+            }
+
+            e->node = node;
+            e->prio = _pos_random(pi);
+
+            _map_put(&pi->map, node, e);
+        }
+
+        e->right = NULL;
+
+        // the 'size' of the entries in the stack is the position of their leftmost node,
+        // when an entry is popped, its subtree is complete
+        popped = NULL;
+
+        for (x = last; x != NULL && x->prio < e->prio; x = x->parent) {
+            x->size = i - x->size;
+            popped  = x;
+        }
+
+        e->left   = popped;
+        e->parent = x;
+        e->size   = popped == NULL ? i : i - popped->size;
+
+        if (popped != NULL) popped->parent = e;
+
+        if (x == NULL) {
+            pi->root = e;
+        } else {
+            x->right = e;
+        }
+
+        last = e;
+    }
+
+    for (x = last; x != NULL; x = x->parent) {
+        x->size = i - x->size;
+    }
+
+    return true;
+}
+
+static struct _pos_entry *_pos_at(struct _pos_index *pi, uint32_t index)
+{
+    struct _pos_entry *e = pi->root;
+
+    while (e != NULL) {
+
+        if (index < _pos_size(e->left)) {
+            e = e->left;
+        } else if (index == _pos_size(e->left)) {
+            break;
+        } else {
+            index -= _pos_size(e->left) + 1;
+            e = e->right;
+        }
+    }
+
+    return e;
+}
+
+static uint32_t _pos_rank(struct _pos_entry *e)
+{
+    uint32_t rank = _pos_size(e->left);
+
+    for (; e->parent != NULL; e = e->parent) {
+        if (e->parent->right == e) {
+            rank += _pos_size(e->parent->left) + 1;
+        }
+    }
+
+    return rank;
+}
+
+static void _pos_free(struct _pos_index *pi)
+{
+    _pos_clear(pi);
+    List_mem_free(pi->map.slots);
+    List_mem_free(pi);
+}
+
+// the position index is an optimization only, if we are out of memory, drop it
+static void _pos_link(List_t *list, ListNode_t *node)
+{
+    struct _pos_entry *prev = NULL;
+
+    if (node->prev != NULL) {
+        prev = _map_find(&list->positions->map, node->prev);
+    }
+
+    if (!_pos_insert(list->positions, prev, node)) {
+        _pos_free(list->positions);
+        list->positions = NULL;
+    }
+}
+
+// the nodes are reordered, rebuild the tree with the same entries
+static void _pos_rebuild(List_t *list)
+{
+    _pos_build(list->positions, list, true);
+}
+
+//----------------------------- priority index -----------------------------------
+
+static List_Inline bool _heap_less(struct _heap_index *hi, struct _heap_entry *a, struct _heap_entry *b)
+{
+    return hi->comparer(a->node->data, b->node->data) < 0;
+}
+
+static List_Inline void _heap_set(struct _heap_index *hi, uint32_t pos, struct _heap_entry *e)
+{
+    hi->heap[pos] = e;
+    e->pos        = pos;
+}
+
+static void _heap_sift_up(struct _heap_index *hi, struct _heap_entry *e)
+{
+    uint32_t pos = e->pos, parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!_heap_less(hi, e, hi->heap[parent])) break;
+        _heap_set(hi, pos, hi->heap[parent]);
+        pos = parent;
+    }
+
+    _heap_set(hi, pos, e);
+}
+
+static void _heap_sift_down(struct _heap_index *hi, struct _heap_entry *e)
+{
+    uint32_t pos = e->pos, child;
+
+    while ((child = pos * 2 + 1) < hi->count) {
+        if (child + 1 < hi->count && _heap_less(hi, hi->heap[child + 1], hi->heap[child])) child++;
+        if (!_heap_less(hi, hi->heap[child], e)) break;
+        _heap_set(hi, pos, hi->heap[child]);
+        pos = child;
+    }
+
+    _heap_set(hi, pos, e);
+}
+
+static bool _heap_insert(struct _heap_index *hi, ListNode_t *node)
+{
+    struct _heap_entry **heap, *e;
+    uint32_t i;
+
+    if (hi->count == hi->capacity) {
+
+        heap = (struct _heap_entry **)List_mem_alloc(hi->capacity * 2 * sizeof(struct _heap_entry *));
+
+        if (heap == NULL) {
+            return false;
+        }
+
+        for (i = 0; i < hi->count; i++) {
+            heap[i] = hi->heap[i];
+        }
+
+        List_mem_free(hi->heap);
+        hi->heap     = heap;
+        hi->capacity = hi->capacity * 2;
+    }
+
+    if (!_map_reserve(&hi->map)) {
+        return false;
+    }
+
+    e = (struct _heap_entry *)List_mem_alloc(sizeof(struct _heap_entry));
+
+    if (e == NULL) {
+        return false;
+    }
+
+    e->node = node;
+    e->pos  = hi->count++;
+
+    _map_put(&hi->map, node, e);
+    _heap_sift_up(hi, e);
+
+    return true;
+}
+
+static void _heap_remove(struct _heap_index *hi, ListNode_t *node)
+{
+    struct _heap_entry *e = _map_find(&hi->map, node), *last;
+
+    if (e == NULL) {
+        return;
+    }
+
+    // move the last entry to the hole, then it goes up or down
+    last = hi->heap[--hi->count];
+
+    if (last != e) {
+        _heap_set(hi, e->pos, last);
+        _heap_sift_up(hi, last);
+        _heap_sift_down(hi, last);
+    }
+
+    _map_remove(&hi->map, node);
+    List_mem_free(e);
+}
+
+// the key of a node is changed, move it to the right position
+static void _heap_update(struct _heap_index *hi, ListNode_t *node)
+{
+    struct _heap_entry *e = _map_find(&hi->map, node);
+
+    if (e != NULL) {
+        _heap_sift_up(hi, e);
+        _heap_sift_down(hi, e);
+    }
+}
+
+static void _heap_clear(struct _heap_index *hi)
+{
+    uint32_t i, mask = _map_mask(&hi->map);
+
+    for (i = 0; i < hi->count; i++) {
+        List_mem_free(hi->heap[i]);
+    }
+
+    for (i = 0; i <= mask; i++) {
+        hi->map.slots[i].node = NULL;
+    }
+
+    hi->count     = 0;
+    hi->map.count = 0;
+}
+
+// the keys of nodes are changed, rebuild the heap with the same entries in O(n)
+static void _heap_rebuild(List_t *list)
+{
+    struct _heap_index *hi = list->heap;
+    uint32_t i;
+
+    for (i = hi->count / 2; i-- > 0;) {
+        _heap_sift_down(hi, hi->heap[i]);
+    }
+}
+
+static void _heap_free(struct _heap_index *hi)
+{
+    _heap_clear(hi);
+    List_mem_free(hi->map.slots);
+    List_mem_free(hi->heap);
+    List_mem_free(hi);
+}
+
+// the priority index is dropped if we are out of memory, same as the position index
+static void _heap_link(List_t *list, ListNode_t *node)
+{
+    if (!_heap_insert(list->heap, node)) {
+        _heap_free(list->heap);
+        list->heap = NULL;
+    }
+}
+
+//----------------------------- list hooks -----------------------------------
+
+// called after a node is linked into the list
+static List_Inline void _list_on_link(List_t *list, ListNode_t *node)
+{
+    if (list->index != NULL) _index_link(list, node);
+    if (list->positions != NULL) _pos_link(list, node);
+    if (list->heap != NULL) _heap_link(list, node);
+#ifdef LIST_BLOCKING_QUEUE
+    if (list->consumers > 0) List_CondSignal(list->not_empty);
+#endif
+}
+
+// called after a chain of nodes is linked into the list
+static List_Inline void _list_on_link_chain(List_t *list, ListNode_t *first, ListNode_t *last)
+{
+    ListNode_t *node;
+
+    if (list->index != NULL) {
+        for (node = first; list->index != NULL; node = node->next) {
+            _index_link(list, node);
+            if (node == last) break;
+        }
+    }
+
+    if (list->positions != NULL) {
+        for (node = first; list->positions != NULL; node = node->next) {
+            _pos_link(list, node);
+            if (node == last) break;
+        }
+    }
+
+    if (list->heap != NULL) {
+        for (node = first; list->heap != NULL; node = node->next) {
+            _heap_link(list, node);
+            if (node == last) break;
+        }
+    }
+
+#ifdef LIST_BLOCKING_QUEUE
+    if (list->consumers > 0) List_CondBroadcast(list->not_empty);
+#endif
+}
+
+// called before a node is unlinked from the list
+static List_Inline void _list_on_unlink(List_t *list, ListNode_t *node)
+{
+    if (list->index != NULL) _index_remove(list->index, node);
+    if (list->positions != NULL) _pos_remove(list->positions, node);
+    if (list->heap != NULL) _heap_remove(list->heap, node);
+#ifdef LIST_BLOCKING_QUEUE
+    if (list->producers > 0) List_CondSignal(list->not_full);
+#endif
+}
+
+// called before a chain of nodes is unlinked from the list
+static List_Inline void _list_on_unlink_chain(List_t *list, ListNode_t *first, ListNode_t *last)
+{
+    ListNode_t *node;
+
+    if (list->index != NULL) {
+        for (node = first;; node = node->next) {
+            _index_remove(list->index, node);
+            if (node == last) break;
+        }
+    }
+
+    if (list->positions != NULL) {
+        for (node = first;; node = node->next) {
+            _pos_remove(list->positions, node);
+            if (node == last) break;
+        }
+    }
+
+    if (list->heap != NULL) {
+        for (node = first;; node = node->next) {
+            _heap_remove(list->heap, node);
+            if (node == last) break;
+        }
+    }
+
+#ifdef LIST_BLOCKING_QUEUE
+    if (list->producers > 0) List_CondBroadcast(list->not_full);
+#endif
+}
+
+// called after all nodes are removed from the list
+static List_Inline void _list_on_clear(List_t *list)
+{
+    if (list->index != NULL) _index_rebuild(list);
+    if (list->positions != NULL) _pos_clear(list->positions);
+    if (list->heap != NULL) _heap_clear(list->heap);
+#ifdef LIST_BLOCKING_QUEUE
+    if (list->producers > 0) List_CondBroadcast(list->not_full);
+#endif
+}
+
+// called after the nodes are relinked in a new order
+static List_Inline void _list_on_reorder(List_t *list)
+{
+    if (list->positions != NULL) _pos_rebuild(list);
+}
+
+// called after the data pointers of nodes are changed
+static List_Inline void _list_on_data_changed(List_t *list)
+{
+    if (list->index != NULL) _index_rebuild(list);
+    if (list->heap != NULL) _heap_rebuild(list);
+}
+
+//----------------------------- epoch reclaim -----------------------------------
+
+#ifdef LIST_EPOCH_RECLAIM
+
+// the low 2 bits of the limbo link: bit 0 marks a retired node (so it's an invalid node),
+// bit 1 marks that the node data need to be destructed
+#define _limbo_next(node)     ((ListNode_t *)((uintptr_t)(node)->prev & ~(uintptr_t)3))
+#define _limbo_destruct(node) (((uintptr_t)(node)->prev & 2) != 0)
+#define _node_retired(node)   (((uintptr_t)(node)->prev & 1) != 0)
+
+static void _epoch_free_chain(List_t *list, ListNode_t *node)
+{
+    ListNode_t *next;
+
+    while (node != NULL) {
+        next = _limbo_next(node);
+        if (_limbo_destruct(node)) list->destructor(node->data);
+        _node_free(list, node);
+        node = next;
+    }
+}
+
+// put a removed node into the limbo of current epoch, the caller must hold the lock
+static List_Inline void _epoch_retire(List_t *list, ListNode_t *node, bool destruct)
+{
+    node->prev = (ListNode_t *)((uintptr_t)list->limbo[list->limbo_pos] | (destruct ? 3 : 1));
+    list->limbo[list->limbo_pos] = node;
+}
+
+// try to advance the epoch, the caller must hold the lock
+static bool _epoch_advance(List_t *list)
+{
+    uint32_t i, v, e = list->epoch;
+    ListNode_t *chain;
+
+    if (list->limbo[0] == NULL && list->limbo[1] == NULL && list->limbo[2] == NULL) {
+        return false; // nothing to reclaim
+    }
+
+    // make the unlinks visible before checking the readers
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // all active readers must have entered in current epoch
+    for (i = 0; i < LIST_EPOCH_READERS; i++) {
+        v = __atomic_load_n(&list->readers[i], __ATOMIC_ACQUIRE);
+        if ((v & _EPOCH_COUNT_MASK) != 0 && (v >> _EPOCH_COUNT_BITS) != (e & _EPOCH_MASK)) {
+            return false;
+        }
+    }
+
+    __atomic_store_n(&list->epoch, e + 1, __ATOMIC_SEQ_CST);
+
+    // the nodes removed 2 epochs ago can't be seen by any reader now
+    list->limbo_pos = (list->limbo_pos + 1) % 3;
+    chain           = list->limbo[(list->limbo_pos + 1) % 3];
+
+    list->limbo[(list->limbo_pos + 1) % 3] = NULL;
+
+    _epoch_free_chain(list, chain);
+
+    return true;
+}
+
+// free all deferred nodes, only used when there are no readers
+static void _epoch_drain(List_t *list)
+{
+    uint32_t i;
+
+    for (i = 0; i < 3; i++) {
+        _epoch_free_chain(list, list->limbo[i]);
+        list->limbo[i] = NULL;
+    }
+}
+
+// the lists which are read by current thread, a nested section of a list must not wait for
+// the relinking writers (they are waiting for the outer section to leave)
+static __thread List_t *_epoch_held[LIST_EPOCH_NESTING];
+static __thread uint32_t _epoch_nested;
+
+static bool _epoch_is_held(List_t *list)
+{
+    uint32_t i, n = _epoch_nested < LIST_EPOCH_NESTING ? _epoch_nested : LIST_EPOCH_NESTING;
+
+    for (i = 0; i < n; i++) {
+        if (_epoch_held[i] == list) return true;
+    }
+
+    return false;
+}
+
+static void _epoch_hold(List_t *list)
+{
+    if (_epoch_nested < LIST_EPOCH_NESTING) _epoch_held[_epoch_nested] = list;
+    _epoch_nested++;
+}
+
+// the sections may not be left in order, so remove the last record of the list
+static void _epoch_unhold(List_t *list)
+{
+    uint32_t i, n = _epoch_nested < LIST_EPOCH_NESTING ? _epoch_nested : LIST_EPOCH_NESTING;
+
+    for (i = n; i > 0; i--) {
+        if (_epoch_held[i - 1] == list) break;
+    }
+
+    if (i > 0) {
+        for (; i < n; i++) _epoch_held[i - 1] = _epoch_held[i];
+    }
+
+    _epoch_nested--;
+}
+
+// the functions which relink the nodes (sort, move them to another list ...) can't run with
+// the lock-free readers, so wait for the readers to leave and make the new readers wait for us;
+// don't hold the lock when waiting, the readers may be waiting for it in their sections
+static void _list_exclude_readers(List_t *list)
+{
+    uint32_t i;
+
+    __atomic_fetch_add(&list->excluders, 1, __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < LIST_EPOCH_READERS; i++) {
+        while ((__atomic_load_n(&list->readers[i], __ATOMIC_SEQ_CST) & _EPOCH_COUNT_MASK) != 0) {
+            List_EpochPause();
+        }
+    }
+}
+
+static List_Inline void _list_admit_readers(List_t *list)
+{
+    __atomic_fetch_sub(&list->excluders, 1, __ATOMIC_RELEASE);
+}
+
+#define _list_collect(list) _epoch_advance(list)
+
+#else
+
+#define _node_retired(node) false
+#define _list_collect(list)
+#define _list_exclude_readers(list)
+#define _list_admit_readers(list)
+
+#endif
+
+// destroy a removed node (and its data), the caller must hold the lock
+static List_Inline void _node_release(List_t *list, ListNode_t *node, bool destruct)
+{
+#ifdef LIST_EPOCH_RECLAIM
+    _epoch_retire(list, node, destruct);
+#else
+    if (destruct) list->destructor(node->data);
+    _node_free(list, node);
+#endif
+}
+
+// free a detached chain of nodes (linked by 'next'), the user data is not freed;
+// in epoch mode, the caller must hold the lock (the readers may still stand on them),
+// otherwise, it's better to call it without the lock
+static void _chain_free(List_t *list, ListNode_t *first, ListNode_t *last)
+{
+    ListNode_t *node, *next;
+
+#ifdef LIST_EPOCH_RECLAIM
+    for (node = first;; node = next) {
+        next = node->next;
+        _node_release(list, node, false);
+        if (node == last) break;
+    }
+    _list_collect(list);
+#else
+    if (list->intrusive) {
+        // the nodes are owned by user data, nothing todo
+    } else if (list->pool != NULL) {
+        _pool_free_chain(list->pool, first, last);
+    } else {
+        for (node = first;; node = next) {
+            next = node->next;
+            List_mem_free(node);
+            if (node == last) break;
+        }
+    }
+#endif
+}
+
+#ifndef LIST_EPOCH_RECLAIM
+
+// destroy a detached chain of 'n' nodes (linked by 'next') and their data,
+// if 'batchDestructor' is not NULL, use it to free all data at once
+static void _chain_destroy(List_t *list, ListNode_t *first, ListNode_t *last, uint32_t n,
+                           ListBatchDestructor_t batchDestructor)
+{
+    ListNode_t *node, *next;
+    void **data, *buf[64];
+    uint32_t i, k;
+
+    if (batchDestructor != NULL) {
+
+        data = (void **)List_mem_alloc(n * sizeof(void *));
+
+        if (data != NULL) {
+            for (i = 0, node = first; i < n; i++, node = node->next) {
+                data[i] = node->data;
+            }
+            _chain_free(list, first, last);
+            batchDestructor(data, n);
+            List_mem_free(data);
+        }
+
+        // no memory for the whole array, free them in small batches
+        else {
+            for (node = first, i = 0; i < n; i += k) {
+                for (k = 0; k < 64 && i + k < n; k++, node = next) {
+                    next   = node->next;
+                    buf[k] = node->data;
+                    _node_free(list, node);
+                }
+                batchDestructor(buf, k);
+            }
+        }
+
+    } else if (list->intrusive) {
+
+        // the destructor may free the user struct which embeds the node
+        if (list->destructor != _null_data_destructor) {
+            for (node = first, i = 0; i < n; i++, node = next) {
+                next = node->next;
+                list->destructor(node->data);
+            }
+        }
+
+    } else {
+
+        if (list->destructor != _null_data_destructor) {
+            for (node = first, i = 0; i < n; i++, node = node->next) {
+                list->destructor(node->data);
+            }
+        }
+
+        _chain_free(list, first, last);
+    }
+}
+
+#endif
+
+// create an empty list which can take the nodes of 'list'
+// the new list shares the node pool, if it's a private pool, the new list becomes one of its owners,
+// so the pool lives until the last owner is destroyed
+static List_t *_list_new_like(List_t *list)
+{
+    List_t *nList = List_CreateList(list->destructor);
+
+    if (nList == NULL) {
+        return NULL;
+    }
+
+    nList->pool      = list->pool;
+    nList->own_pool  = list->own_pool;
+    nList->intrusive = list->intrusive;
+
+    if (nList->own_pool) {
+        List_PoolLock(nList->pool);
+        nList->pool->owners++;
+        List_PoolUnLock(nList->pool);
+    }
+
+    return nList;
+}
+
+// the nodes can be moved between two lists only if they are allocated in the same way
+static List_Inline bool _list_same_alloc(List_t *list1, List_t *list2)
+{
+    return list1->pool == list2->pool && list1->intrusive == list2->intrusive;
+}
+
+// lock two lists in address order to avoid deadlock
+static void _list_lock_pair(List_t *list1, List_t *list2)
+{
+    if ((uintptr_t)list1 < (uintptr_t)list2) {
+        List_Lock(list1);
+        List_Lock(list2);
+    } else {
+        List_Lock(list2);
+        List_Lock(list1);
+    }
+}
+
+static void _list_unlock_pair(List_t *list1, List_t *list2)
+{
+#ifdef LIST_THREAD_SAFED
+    List_UnLock(list1);
+    List_UnLock(list2);
+#else
+    (void)list1;
+    (void)list2;
+#endif
+}
+
+//----------------------------- list link -----------------------------------
+
+static List_Inline void _list_push_node(List_t *list, ListNode_t *node)
+{
+    if (list->length == 0) {
+        _list_store(list->head, node);
+        _list_store(list->tail, node);
+    } else {
+        node->prev = list->tail;
+        _link_store(list->tail->next, node);
+        _list_store(list->tail, node);
+    }
+
+    _list_store(list->length, list->length + 1);
+
+    _list_on_link(list, node);
+}
+
+static List_Inline void _list_prepend_node(List_t *list, ListNode_t *node)
+{
+    if (list->length == 0) {
+        _list_store(list->head, node);
+        _list_store(list->tail, node);
+    } else {
+        node->next       = list->head;
+        list->head->prev = node;
+        _list_store(list->head, node);
+    }
+
+    _list_store(list->length, list->length + 1);
+
+    _list_on_link(list, node);
+}
+
+// link a chain after 'prev' (if 'prev' is NULL, link it at front of the list)
+static void _list_insert_chain(List_t *list, ListNode_t *prev,
+                               ListNode_t *first, ListNode_t *last, uint32_t n)
+{
+    ListNode_t *next = prev == NULL ? list->head : prev->next;
+
+    first->prev = prev;
+    last->next  = next;
+
+    if (next != NULL) {
+        next->prev = last;
+    } else {
+        _list_store(list->tail, last);
+    }
+
+    if (prev != NULL) {
+        _link_store(prev->next, first);
+    } else {
+        _list_store(list->head, first);
+    }
+
+    _list_store(list->length, list->length + n);
+
+    _list_on_link_chain(list, first, last);
+}
+
+// detach up to 'max' nodes from the front of the list as a chain,
+// return the number of the detached nodes
+static uint32_t _list_detach_front(List_t *list, uint32_t max, ListNode_t **first, ListNode_t **last)
+{
+    ListNode_t *node;
+    uint32_t i, n = max < list->length ? max : list->length;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    *first = list->head;
+
+    if (n == list->length) {
+        *last = list->tail;
+        _list_store(list->head, NULL);
+        _list_store(list->tail, NULL);
+        _list_store(list->length, 0);
+        _list_on_clear(list);
+        return n;
+    }
+
+    for (i = 1, node = list->head; i < n; i++) {
+        node = node->next;
+    }
+
+    *last = node;
+
+    _list_on_unlink_chain(list, *first, node);
+
+    _list_store(list->head, node->next);
+    list->head->prev = NULL;
+    _link_store(node->next, NULL);
+    _list_store(list->length, list->length - n);
+
+    return n;
+}
+
+// detach up to 'max' nodes from the end of the list as a chain,
+// return the number of the detached nodes
+static uint32_t _list_detach_back(List_t *list, uint32_t max, ListNode_t **first, ListNode_t **last)
+{
+    ListNode_t *node;
+    uint32_t i, n = max < list->length ? max : list->length;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    *last = list->tail;
+
+    if (n == list->length) {
+        *first = list->head;
+        _list_store(list->head, NULL);
+        _list_store(list->tail, NULL);
+        _list_store(list->length, 0);
+        _list_on_clear(list);
+        return n;
+    }
+
+    for (i = 1, node = list->tail; i < n; i++) {
+        node = node->prev;
+    }
+
+    *first = node;
+
+    _list_on_unlink_chain(list, node, *last);
+
+    _list_store(list->tail, node->prev);
+    _link_store(list->tail->next, NULL);
+    node->prev = NULL;
+    _list_store(list->length, list->length - n);
+
+    return n;
+}
+
+// unlink all matched nodes in one forward pass, the other nodes are relinked in place,
+// the matched nodes are returned as a chain (linked by 'next', keep the order);
+// in epoch mode, if 'retire' is true, the matched nodes are retired and not returned
+// return the number of the matched nodes
+static uint32_t _list_unlink_matched(List_t *list, ListNodeMatcher_t matcher, void *params,
+                                     bool retire, ListNode_t **first, ListNode_t **last)
+{
+    ListNode_t *node, *next, *prev = NULL, *vLast = NULL;
+    uint32_t n = 0;
+
+    *first = NULL;
+
+    for (node = list->head; node != NULL; node = next) {
+
+        next = node->next;
+
+        if (matcher(node->data, params)) {
+
+            _list_on_unlink(list, node);
+            n++;
+
+#ifdef LIST_EPOCH_RECLAIM
+            // keep its 'next' for the readers
+            if (retire) {
+                _node_release(list, node, true);
+                continue;
+            }
+#else
+            (void)retire;
+#endif
+            node->prev = vLast;
+
+            if (vLast == NULL) {
+                *first = node;
+            } else {
+                vLast->next = node;
+            }
+
+            vLast = node;
+        }
+
+        // the node before it has been removed, relink it
+        else {
+
+            if (node->prev != prev) {
+
+                node->prev = prev;
+
+                if (prev == NULL) {
+                    _list_store(list->head, node);
+                } else {
+                    _link_store(prev->next, node);
+                }
+            }
+
+            prev = node;
+        }
+    }
+
+    if (n > 0) {
+
+        if (prev == NULL) {
+            _list_store(list->head, NULL);
+        } else {
+            _link_store(prev->next, NULL);
+        }
+
+        _list_store(list->tail, prev);
+        _list_store(list->length, list->length - n);
+    }
+
+    if (vLast != NULL) {
+        vLast->next = NULL;
+    }
+
+    *last = vLast;
+
+    return n;
+}
+
+static ListNode_t *_list_pop(List_t *list)
+{
+    ListNode_t *node = NULL;
+
+    if (list->length == 0) {
+        return node;
+    }
+
+    _list_on_unlink(list, list->tail);
+
+    if (list->head == list->tail) {
+        node         = list->head;
+        _list_store(list->head, NULL);
+        _list_store(list->tail, NULL);
+        _list_store(list->length, 0);
+    } else {
+        node       = list->tail;
+        _list_store(list->tail, node->prev);
+        _cut_prev(node);
+        _list_store(list->length, list->length - 1);
+    }
+
+    return node;
+}
+
+static ListNode_t *_list_dequeue(List_t *list)
+{
+    ListNode_t *node = NULL;
+
+    if (list->length == 0) {
+        return node;
+    }
+
+    _list_on_unlink(list, list->head);
+
+    if (list->head == list->tail) {
+        node         = list->head;
+        _list_store(list->head, NULL);
+        _list_store(list->tail, NULL);
+        _list_store(list->length, 0);
+    } else {
+        node       = list->head;
+        _list_store(list->head, node->next);
+        _cut_next(node);
+        _list_store(list->length, list->length - 1);
+    }
+
+    return node;
+}
+
+static ListNode_t *_list_remove_node(List_t *list, ListNode_t *node)
+{
+    ListNode_t *prev, *next;
+
+    if (list->length == 0) {
+        return NULL;
+    }
+
+    if ((node != list->head && node != list->tail &&
+         (node->prev == NULL || node->next == NULL)) ||
+        _node_retired(node)) {
+        return NULL; // invalid node, skip
+    }
+
+    _list_on_unlink(list, node);
+
+    if (node == list->head) {
+        if (node->next != NULL) {
+            _list_store(list->head, node->next);
+            _cut_next(node);
+        } else {
+            _list_store(list->head, NULL);
+            _list_store(list->tail, NULL);
+        }
+    }
+
+    else if (node == list->tail) {
+        if (node->prev != NULL) {
+            _list_store(list->tail, node->prev);
+            _cut_prev(node);
+        } else {
+            _list_store(list->head, NULL);
+            _list_store(list->tail, NULL);
+        }
+    }
+
+    else {
+        prev = node->prev;
+        next = node->next;
+        _link_store(prev->next, next);
+        next->prev = prev;
+        node->prev = NULL;
+#ifndef LIST_EPOCH_RECLAIM
+        node->next = NULL;
+#endif
+    }
+
+    _list_store(list->length, list->length - 1);
+
+    return node;
+}
+
+// get the node at a position, NULL if out of range
+static ListNode_t *_list_at(List_t *list, uint32_t index)
+{
+    ListNode_t *node;
+    uint32_t i;
+
+    if (index >= list->length) {
+        return NULL;
+    }
+
+    if (list->positions != NULL) {
+        return _pos_at(list->positions, index)->node;
+    }
+
+    // walk from the nearer end
+    if (index < list->length / 2) {
+        for (i = 0, node = list->head; i < index; i++) node = node->next;
+    } else {
+        for (i = list->length - 1, node = list->tail; i > index; i--) node = node->prev;
+    }
+
+    return node;
+}
+
+static ListNode_t *_list_find_first(List_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    ListNode_t *node = _list_load(list->head);
+
+    while (node != NULL) {
+        if (matcher(node->data, params)) break;
+        node = _link_load(node->next);
+    }
+
+    return node;
+}
+
+//-------------------------------------------------------
+
+List_t *List_CreateList(ListDataDestructor_t destructor)
+{
+    List_t *list = (List_t *)List_mem_alloc(sizeof(List_t));
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    list->length      = 0;
+    list->head        = NULL;
+    list->tail        = NULL;
+    list->destructor  = destructor == NULL ? _null_data_destructor : destructor;
+    list->pool        = NULL;
+    list->own_pool    = false;
+    list->intrusive   = false;
+    list->index       = NULL;
+    list->positions   = NULL;
+    list->heap        = NULL;
+    list->pq_comparer = NULL;
+
+#ifdef LIST_THREAD_SAFED
+    list->lock = List_LockNew();
+#endif
+
+#ifdef LIST_BLOCKING_QUEUE
+    list->not_empty = List_CondNew();
+    list->not_full  = List_CondNew();
+    list->capacity  = 0;
+    list->consumers = 0;
+    list->producers = 0;
+    list->closed    = false;
+#endif
+
+#ifdef LIST_EPOCH_RECLAIM
+    {
+        uint32_t i;
+
+        list->epoch     = 0;
+        list->limbo_pos = 0;
+        list->excluders = 0;
+
+        for (i = 0; i < LIST_EPOCH_READERS; i++) list->readers[i] = 0;
+        for (i = 0; i < 3; i++) list->limbo[i] = NULL;
+    }
+#endif
+
+    return list;
+}
+
+List_t *List_CreateListWithPool(ListDataDestructor_t destructor, ListNodePool_t *pool)
+{
+    List_t *list = List_CreateList(destructor);
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    if (pool == NULL) {
+
+        list->pool = List_CreateNodePool(0);
+
+        if (list->pool == NULL) {
+            List_DestroyList(list);
+            return NULL;
+        }
+
+        list->pool->owners = 1;
+        list->own_pool     = true;
+
+    } else {
+        list->pool = pool;
+    }
+
+    return list;
+}
+
+List_t *List_CreateIntrusiveList(ListDataDestructor_t destructor)
+{
+    List_t *list = List_CreateList(destructor);
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    list->intrusive = true;
+
+    return list;
+}
+
+void List_DestroyList(List_t *list)
+{
+    ListNode_t *node;
+    bool lastOwner = false;
+
+    // drop the indexes first, so the nodes can be released without updating them
+    List_DestroyIndex(list);
+    List_DestroyPositionIndex(list);
+    List_DestroyPriorityIndex(list);
+
+    // the private pool may be shared with the lists made by 'List_DequeueList', 'List_SplitAt' ...
+    if (list->own_pool) {
+        List_PoolLock(list->pool);
+        lastOwner = --list->pool->owners == 0;
+        List_PoolUnLock(list->pool);
+    }
+
+    if (lastOwner) {
+
+        // all nodes are living in the private pool, so we only need to
+        // call the destructor and then release the whole slabs at once
+        if (list->destructor != _null_data_destructor) {
+            for (node = list->head; node != NULL; node = node->next) {
+                list->destructor(node->data);
+            }
+        }
+
+#ifdef LIST_EPOCH_RECLAIM
+        _epoch_drain(list);
+#endif
+        List_DestroyNodePool(list->pool);
+
+    } else {
+        List_Clear(list);
+#ifdef LIST_EPOCH_RECLAIM
+        _epoch_drain(list);
+#endif
+    }
+
+#ifdef LIST_BLOCKING_QUEUE
+    List_CondFree(list->not_empty);
+    List_CondFree(list->not_full);
+#endif
+#ifdef LIST_THREAD_SAFED
+    List_LockFree(list->lock);
+#endif
+    List_mem_free(list);
+}
+
+ListNodePool_t *List_CreateNodePool(uint32_t chunk_size)
+{
+    ListNodePool_t *pool = (ListNodePool_t *)List_mem_alloc(sizeof(ListNodePool_t));
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->slabs      = NULL;
+    pool->free_nodes = NULL;
+    pool->bump       = NULL;
+    pool->bump_end   = NULL;
+    pool->chunk_size = chunk_size == 0 ? LIST_NODE_POOL_CHUNK_SIZE : chunk_size;
+    pool->owners     = 0;
+
+#ifdef LIST_THREAD_SAFED
+    pool->lock = List_LockNew();
+#endif
+
+    return pool;
+}
+
+void List_DestroyNodePool(ListNodePool_t *pool)
+{
+    struct _node_slab *slab, *next;
+
+    for (slab = pool->slabs; slab != NULL; slab = next) {
+        next = slab->next;
+        List_mem_free(slab);
+    }
+
+#ifdef LIST_THREAD_SAFED
+    List_LockFree(pool->lock);
+#endif
+    List_mem_free(pool);
+}
+
+bool List_CreateIndex(List_t *list, ListDataHasher_t hasher, ListNodeComparer_t comparer)
+{
+    struct _hash_index *index;
+    ListNode_t *node;
+    bool done = true;
+
+    List_Lock(list);
+    {
+        if (list->index == NULL) {
+
+            index = (struct _hash_index *)List_mem_alloc(sizeof(struct _hash_index));
+
+            if (index != NULL) {
+
+                index->slots    = NULL;
+                index->count    = 0;
+                index->hasher   = hasher;
+                index->comparer = comparer;
+
+                // the initial capacity: 16 slots
+                if (_index_resize(index, 32 - 4)) {
+
+                    list->index = index;
+
+                    for (node = list->head; node != NULL && list->index != NULL; node = node->next) {
+                        _index_link(list, node);
+                    }
+
+                    done = list->index != NULL;
+
+                } else {
+                    List_mem_free(index);
+                    done = false;
+                }
+
+            } else {
+                done = false;
+            }
+        }
+    }
+    List_UnLock(list);
+
+    return done;
+}
+
+void List_DestroyIndex(List_t *list)
+{
+    List_Lock(list);
+    {
+        if (list->index != NULL) {
+            _index_free(list->index);
+            list->index = NULL;
+        }
+    }
+    List_UnLock(list);
+}
+
+ListNode_t *List_FindByKey(List_t *list, void *key)
+{
+    ListNode_t *node = NULL;
+
+    List_LockShared(list);
+    {
+        if (list->index != NULL) {
+            node = _index_find(list->index, key);
+        }
+    }
+    List_UnLockShared(list);
+
+    return node;
+}
+
+bool List_DeleteByKey(List_t *list, void *key)
+{
+    ListNode_t *node = NULL;
+
+    List_Lock(list);
+    {
+        if (list->index != NULL) {
+            node = _index_find(list->index, key);
+        }
+
+        if (node != NULL) {
+            _list_remove_node(list, node);
+            _node_release(list, node, true);
+            _list_collect(list);
+        }
+    }
+    List_UnLock(list);
+
+    return node != NULL;
+}
+
+bool List_CreatePositionIndex(List_t *list)
+{
+    struct _pos_index *pi;
+    bool done = true;
+
+    List_Lock(list);
+    {
+        if (list->positions == NULL) {
+
+            pi = (struct _pos_index *)List_mem_alloc(sizeof(struct _pos_index));
+
+            if (pi != NULL) {
+
+                pi->root      = NULL;
+                pi->map.slots = NULL;
+                pi->map.count = 0;
+                pi->seed      = (uint32_t)(uintptr_t)pi | 1;
+
+                // the initial capacity: 16 slots
+                if (_map_resize(&pi->map, 32 - 4) && _pos_build(pi, list, false)) {
+                    list->positions = pi;
+                } else {
+                    if (pi->map.slots != NULL) _pos_free(pi);
+                    else List_mem_free(pi);
+                    done = false;
+                }
+
+            } else {
+                done = false;
+            }
+        }
+    }
+    List_UnLock(list);
+
+    return done;
+}
+
+void List_DestroyPositionIndex(List_t *list)
+{
+    List_Lock(list);
+    {
+        if (list->positions != NULL) {
+            _pos_free(list->positions);
+            list->positions = NULL;
+        }
+    }
+    List_UnLock(list);
+}
+
+ListNode_t *List_At(List_t *list, uint32_t index)
+{
+    ListNode_t *node;
+    List_LockShared(list);
+    node = _list_at(list, index);
+    List_UnLockShared(list);
+    return node;
+}
+
+uint32_t List_IndexOf(List_t *list, ListNode_t *node)
+{
+    struct _pos_entry *e;
+    ListNode_t *cur;
+    uint32_t index = UINT32_MAX, i;
+
+    List_LockShared(list);
+    {
+        if (list->positions != NULL) {
+            e = _map_find(&list->positions->map, node);
+            if (e != NULL) index = _pos_rank(e);
+        } else {
+            for (i = 0, cur = list->head; cur != NULL; i++, cur = cur->next) {
+                if (cur == node) {
+                    index = i;
+                    break;
+                }
+            }
+        }
+    }
+    List_UnLockShared(list);
+
+    return index;
+}
+
+ListNode_t *List_InsertAt(List_t *list, uint32_t index, void *data)
+{
+    ListNode_t *node, *nNode;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    nNode = _node_new(list, data);
+
+    List_Lock(list);
+    {
+        node = _list_at(list, index);
+
+        if (node == NULL) {
+            _list_push_node(list, nNode);
+        } else if (node == list->head) {
+            _list_prepend_node(list, nNode);
+        } else {
+            _link_next(node->prev, nNode);
+            _list_store(list->length, list->length + 1);
+            _list_on_link(list, nNode);
+        }
+    }
+    List_UnLock(list);
+
+    return nNode;
+}
+
+bool List_CreatePriorityIndex(List_t *list, ListNodeComparer_t comparer)
+{
+    struct _heap_index *hi;
+    ListNode_t *node;
+    bool done = true;
+
+    List_Lock(list);
+    {
+        if (list->heap != NULL) {
+            // a new comparer, reorder the heap with the same entries
+            list->heap->comparer = comparer;
+            _heap_rebuild(list);
+        } else {
+
+            hi = (struct _heap_index *)List_mem_alloc(sizeof(struct _heap_index));
+
+            if (hi != NULL) {
+
+                hi->count     = 0;
+                hi->capacity  = 16;
+                hi->comparer  = comparer;
+                hi->map.slots = NULL;
+                hi->map.count = 0;
+                hi->heap      = (struct _heap_entry **)List_mem_alloc(hi->capacity * sizeof(struct _heap_entry *));
+
+                // the initial capacity: 16 slots
+                if (hi->heap != NULL && _map_resize(&hi->map, 32 - 4)) {
+
+                    list->heap = hi;
+
+                    for (node = list->head; node != NULL && list->heap != NULL; node = node->next) {
+                        _heap_link(list, node);
+                    }
+
+                    done = list->heap != NULL;
+
+                } else {
+                    if (hi->heap != NULL) List_mem_free(hi->heap);
+                    List_mem_free(hi);
+                    done = false;
+                }
+
+            } else {
+                done = false;
+            }
+        }
+
+        list->pq_comparer = done ? comparer : NULL;
+    }
+    List_UnLock(list);
+
+    return done;
+}
+
+void List_DestroyPriorityIndex(List_t *list)
+{
+    List_Lock(list);
+    {
+        if (list->heap != NULL) {
+            _heap_free(list->heap);
+            list->heap = NULL;
+        }
+
+        list->pq_comparer = NULL;
+    }
+    List_UnLock(list);
+}
+
+// find the min node, use the heap top if we have the index, otherwise scan the list (the index was dropped)
+static ListNode_t *_pq_min(List_t *list)
+{
+    ListNode_t *node, *min = NULL;
+
+    if (list->heap != NULL) {
+        return list->heap->count > 0 ? list->heap->heap[0]->node : NULL;
+    }
+
+    if (list->pq_comparer != NULL) {
+        for (node = list->head; node != NULL; node = node->next) {
+            if (min == NULL || list->pq_comparer(node->data, min->data) < 0) min = node;
+        }
+    }
+
+    return min;
+}
+
+ListNode_t *List_PQInsert(List_t *list, void *data)
+{
+    return List_Push(list, data);
+}
+
+ListNode_t *List_PQPeekMin(List_t *list)
+{
+    ListNode_t *node;
+
+    List_LockShared(list);
+    node = _pq_min(list);
+    List_UnLockShared(list);
+
+    return node;
+}
+
+ListNode_t *List_PQPopMin(List_t *list)
+{
+    ListNode_t *node;
+
+    List_Lock(list);
+    {
+        node = _pq_min(list);
+
+        if (node != NULL) {
+            node = _list_remove_node(list, node);
+        }
+    }
+    List_UnLock(list);
+
+    return node;
+}
+
+void List_PQDecreaseKey(List_t *list, ListNode_t *node)
+{
+    List_Lock(list);
+    {
+        if (list->heap != NULL) {
+            _heap_update(list->heap, node);
+        }
+    }
+    List_UnLock(list);
+}
+
+ListNode_t *List_InsertSorted(List_t *list, ListNodeComparer_t comparer, void *data)
+{
+    ListNode_t *node, *nNode;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    nNode = _node_new(list, data);
+
+    List_Lock(list);
+    {
+        // search from the tail, so appending in order is O(1), and the equal nodes keep their order
+        for (node = list->tail; node != NULL && comparer(node->data, data) > 0; node = node->prev)
+            ;
+
+        if (node == NULL) {
+            _list_prepend_node(list, nNode);
+        } else if (node == list->tail) {
+            _list_push_node(list, nNode);
+        } else {
+            _link_next(node, nNode);
+            _list_store(list->length, list->length + 1);
+            _list_on_link(list, nNode);
+        }
+    }
+    List_UnLock(list);
+
+    return nNode;
+}
+
+void List_FreeNode(List_t *list, ListNode_t *node)
+{
+#ifdef LIST_EPOCH_RECLAIM
+    // the readers may still stand on it
+    List_Lock(list);
+    _node_release(list, node, false);
+    _list_collect(list);
+    List_UnLock(list);
+#else
+    _node_free(list, node);
+#endif
+}
+
+void List_Clear(List_t *list)
+{
+    ListNode_t *node, *next, *first, *last;
+    bool destruct = list->destructor != _null_data_destructor;
+
+    // detach the whole chain at once, then walk it only one time
+    List_Lock(list);
+    {
+        first = list->head;
+        last  = list->tail;
+
+        _list_store(list->head, NULL);
+        _list_store(list->tail, NULL);
+        _list_store(list->length, 0);
+
+        _list_on_clear(list);
+
+#ifdef LIST_EPOCH_RECLAIM
+        // the readers can still walk on the chain
+        while (first != NULL) {
+            node  = first;
+            first = node == last ? NULL : node->next;
+            _node_release(list, node, true);
+        }
+
+        _list_collect(list);
+#endif
+    }
+    List_UnLock(list);
+
+    if (first == NULL) {
+        return;
+    }
+
+    // the chain is not reachable from the list, so free it without the lock
+    if (list->pool != NULL) {
+
+        if (destruct) {
+            for (node = first; node != NULL; node = node->next) {
+                list->destructor(node->data);
+            }
+        }
+
+        // the nodes are still linked, give back the whole chain
+        _pool_free_chain(list->pool, first, last);
+
+    } else if (list->intrusive) {
+
+        // the destructor may free the user struct which embeds the node
+        if (destruct) {
+            for (node = first; node != NULL; node = next) {
+                next = node->next;
+                list->destructor(node->data);
+            }
+        }
+
+    } else {
+
+        for (node = first; node != NULL; node = next) {
+            next = node->next;
+            if (destruct) list->destructor(node->data);
+            List_mem_free(node);
+        }
+    }
+}
+
+ListNode_t *List_Pop(List_t *list)
+{
+    ListNode_t *node;
+    List_Lock(list);
+    node = _list_pop(list);
+    List_UnLock(list);
+    return node;
+}
+
+ListNode_t *List_Push(List_t *list, void *data)
+{
+    ListNode_t *node;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    node = _node_new(list, data);
+
+    List_Lock(list);
+    _list_push_node(list, node);
+    List_UnLock(list);
+
+    return node;
+}
+
+ListNode_t *List_Prepend(List_t *list, void *data)
+{
+    ListNode_t *node;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    node = _node_new(list, data);
+
+    List_Lock(list);
+    _list_prepend_node(list, node);
+    List_UnLock(list);
+
+    return node;
+}
+
+ListNode_t *List_PushBatch(List_t *list, void **data, uint32_t n)
+{
+    ListNode_t *first, *last;
+
+    if (n == 0 || list->intrusive) {
+        return NULL;
+    }
+
+    first = _chain_new(list, data, n, &last);
+
+    List_Lock(list);
+    _list_insert_chain(list, list->tail, first, last, n);
+    List_UnLock(list);
+
+    return first;
+}
+
+ListNode_t *List_PrependBatch(List_t *list, void **data, uint32_t n)
+{
+    ListNode_t *first, *last;
+
+    if (n == 0 || list->intrusive) {
+        return NULL;
+    }
+
+    first = _chain_new(list, data, n, &last);
+
+    List_Lock(list);
+    _list_insert_chain(list, NULL, first, last, n);
+    List_UnLock(list);
+
+    return first;
+}
+
+ListNode_t *List_InsertBatch(List_t *list, ListNode_t *node, void **data, uint32_t n)
+{
+    ListNode_t *first, *last;
+
+    if (n == 0 || list->intrusive) {
+        return NULL;
+    }
+
+    first = _chain_new(list, data, n, &last);
+
+    List_Lock(list);
+    _list_insert_chain(list, node, first, last, n);
+    List_UnLock(list);
+
+    return first;
+}
+
+ListNode_t *List_PushIntrusive(List_t *list, ListNode_t *node, void *data)
+{
+    node->data = data;
+    node->next = NULL;
+    node->prev = NULL;
+
+    List_Lock(list);
+    _list_push_node(list, node);
+    List_UnLock(list);
+
+    return node;
+}
+
+ListNode_t *List_PrependIntrusive(List_t *list, ListNode_t *node, void *data)
+{
+    node->data = data;
+    node->next = NULL;
+    node->prev = NULL;
+
+    List_Lock(list);
+    _list_prepend_node(list, node);
+    List_UnLock(list);
+
+    return node;
+}
+
+ListNode_t *List_RemoveIntrusive(List_t *list, ListNode_t *node)
+{
+    return List_RemoveNode(list, node);
+}
+
+ListNode_t *List_Dequeue(List_t *list)
+{
+    ListNode_t *node;
+    List_Lock(list);
+    node = _list_dequeue(list);
+    List_UnLock(list);
+    return node;
+}
+
+#ifdef LIST_BLOCKING_QUEUE
+
+void List_SetCapacity(List_t *list, uint32_t capacity)
+{
+    List_Lock(list);
+    {
+        list->capacity = capacity;
+
+        // maybe there is more space now
+        if (list->producers > 0) List_CondBroadcast(list->not_full);
+    }
+    List_UnLock(list);
+}
+
+bool List_EnqueueWait(List_t *list, void *data, uint32_t timeout)
+{
+    ListNode_t *node;
+    bool done = false;
+
+    if (list->intrusive) {
+        return false;
+    }
+
+    node = _node_new(list, data);
+
+    List_Lock(list);
+    {
+        // a spurious wakeup will restart the timeout
+        while (!list->closed && list->capacity != 0 &&
+               list->length >= list->capacity && timeout != 0) {
+
+            list->producers++;
+            done = List_CondWait(list->not_full, list->lock, timeout);
+            list->producers--;
+
+            if (!done) break;
+        }
+
+        done = !list->closed && (list->capacity == 0 || list->length < list->capacity);
+
+        if (done) {
+            _list_push_node(list, node);
+        }
+    }
+    List_UnLock(list);
+
+    // the node has never been linked, free it directly
+    if (!done) {
+        _node_free(list, node);
+    }
+
+    return done;
+}
+
+bool List_DequeueWait(List_t *list, void **data, uint32_t timeout)
+{
+    ListNode_t *node;
+    bool signaled;
+
+    List_Lock(list);
+    {
+        while (!list->closed && list->length == 0 && timeout != 0) {
+
+            list->consumers++;
+            signaled = List_CondWait(list->not_empty, list->lock, timeout);
+            list->consumers--;
+
+            if (!signaled) break;
+        }
+
+        node = _list_dequeue(list);
+    }
+    List_UnLock(list);
+
+    if (node == NULL) {
+        return false;
+    }
+
+    *data = node->data;
+    List_FreeNode(list, node);
+
+    return true;
+}
+
+void List_Close(List_t *list)
+{
+    List_Lock(list);
+    {
+        list->closed = true;
+        List_CondBroadcast(list->not_empty);
+        List_CondBroadcast(list->not_full);
+    }
+    List_UnLock(list);
+}
+
+bool List_IsClosed(List_t *list)
+{
+    bool closed;
+    List_Lock(list);
+    closed = list->closed;
+    List_UnLock(list);
+    return closed;
+}
+
+#endif
+
+uint32_t List_DequeueBatch(List_t *list, void **out, uint32_t max)
+{
+    ListNode_t *first, *last, *node;
+    uint32_t i, n;
+
+    List_Lock(list);
+    {
+        n = _list_detach_front(list, max, &first, &last);
+
+        for (i = 0, node = first; i < n; i++, node = node->next) {
+            out[i] = node->data;
+        }
+
+#ifdef LIST_EPOCH_RECLAIM
+        if (n > 0) _chain_free(list, first, last);
+#endif
+    }
+    List_UnLock(list);
+
+#ifndef LIST_EPOCH_RECLAIM
+    if (n > 0) _chain_free(list, first, last);
+#endif
+
+    return n;
+}
+
+uint32_t List_PopBatch(List_t *list, void **out, uint32_t max)
+{
+    ListNode_t *first, *last, *node;
+    uint32_t i, n;
+
+    List_Lock(list);
+    {
+        n = _list_detach_back(list, max, &first, &last);
+
+        for (i = 0, node = last; i < n; i++, node = node->prev) {
+            out[i] = node->data;
+        }
+
+#ifdef LIST_EPOCH_RECLAIM
+        if (n > 0) _chain_free(list, first, last);
+#endif
+    }
+    List_UnLock(list);
+
+#ifndef LIST_EPOCH_RECLAIM
+    if (n > 0) _chain_free(list, first, last);
+#endif
+
+    return n;
+}
+
+List_t *List_DequeueList(List_t *list, uint32_t max)
+{
+    List_t *nList = _list_new_like(list);
+    ListNode_t *first, *last;
+    uint32_t n;
+
+    if (nList == NULL) {
+        return NULL;
+    }
+
+    _list_exclude_readers(list);
+    List_Lock(list);
+    n = _list_detach_front(list, max, &first, &last);
+    List_UnLock(list);
+    _list_admit_readers(list);
+
+    if (n > 0) {
+        nList->head   = first;
+        nList->tail   = last;
+        nList->length = n;
+    }
+
+    return nList;
+}
+
+bool List_Splice(List_t *dst, ListNode_t *node, List_t *src)
+{
+    ListNode_t *first, *last;
+    uint32_t n;
+
+    if (dst == src || !_list_same_alloc(dst, src)) {
+        return false;
+    }
+
+    _list_exclude_readers(src);
+    _list_lock_pair(dst, src);
+    {
+        n = src->length;
+
+        if (n > 0) {
+
+            first = src->head;
+            last  = src->tail;
+
+            _list_store(src->head, NULL);
+            _list_store(src->tail, NULL);
+            _list_store(src->length, 0);
+
+            _list_on_clear(src);
+
+            _list_insert_chain(dst, node, first, last, n);
+        }
+    }
+    _list_unlock_pair(dst, src);
+    _list_admit_readers(src);
+
+    return true;
+}
+
+bool List_Concat(List_t *dst, List_t *src)
+{
+    ListNode_t *first, *last;
+    uint32_t n;
+
+    if (dst == src || !_list_same_alloc(dst, src)) {
+        return false;
+    }
+
+    _list_exclude_readers(src);
+    _list_lock_pair(dst, src);
+    {
+        n = src->length;
+
+        if (n > 0) {
+
+            first = src->head;
+            last  = src->tail;
+
+            _list_store(src->head, NULL);
+            _list_store(src->tail, NULL);
+            _list_store(src->length, 0);
+
+            _list_on_clear(src);
+
+            _list_insert_chain(dst, dst->tail, first, last, n);
+        }
+    }
+    _list_unlock_pair(dst, src);
+    _list_admit_readers(src);
+
+    return true;
+}
+
+List_t *List_SplitAt(List_t *list, ListNode_t *node)
+{
+    List_t *nList = _list_new_like(list);
+    ListNode_t *last, *cur;
+    uint32_t n = 0;
+
+    if (nList == NULL || node == NULL) {
+        return nList;
+    }
+
+    _list_exclude_readers(list);
+    List_Lock(list);
+    {
+        for (cur = node; cur != NULL; cur = cur->next) {
+            n++;
+        }
+
+        last = list->tail;
+
+        _list_on_unlink_chain(list, node, last);
+
+        if (node == list->head) {
+            _list_store(list->head, NULL);
+            _list_store(list->tail, NULL);
+        } else {
+            _list_store(list->tail, node->prev);
+            _link_store(node->prev->next, NULL);
+            node->prev = NULL;
+        }
+
+        _list_store(list->length, list->length - n);
+    }
+    List_UnLock(list);
+    _list_admit_readers(list);
+
+    nList->head   = node;
+    nList->tail   = last;
+    nList->length = n;
+
+    return nList;
+}
+
+ListNode_t *List_Enqueue(List_t *list, void *data)
+{
+    return List_Push(list, data);
+}
+
+ListNode_t *List_FindFirst(List_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    ListNode_t *node;
+    uint32_t ticket;
+    ticket = List_EpochEnter(list);
+    node   = _list_find_first(list, matcher, params);
+    List_EpochExit(list, ticket);
+    return node;
+}
+
+ListNode_t *List_FindNext(List_t *list, ListNode_t *node,
+                          ListNodeMatcher_t matcher, void *params)
+{
+    ListNode_t *cNode;
+    uint32_t ticket;
+
+    ticket = List_EpochEnter(list);
+    {
+        cNode = _link_load(node->next);
+
+        while (cNode != NULL) {
+            if (matcher(cNode->data, params)) break;
+            cNode = _link_load(cNode->next);
+        }
+    }
+    List_EpochExit(list, ticket);
+
+    return cNode;
+}
+
+ListNode_t *List_First(List_t *list)
+{
+    ListNode_t *node;
+    List_LockField(list);
+    node = _list_load(list->head);
+    List_UnLockField(list);
+    return node;
+}
+
+ListNode_t *List_Last(List_t *list)
+{
+    ListNode_t *node;
+    List_LockField(list);
+    node = _list_load(list->tail);
+    List_UnLockField(list);
+    return node;
+}
+
+uint32_t List_Length(List_t *list)
+{
+    uint32_t len;
+    List_LockField(list);
+    len = _list_load(list->length);
+    List_UnLockField(list);
+    return len;
+}
+
+ListNode_t *List_InsertNode(List_t *list, ListNode_t *node, void *data)
+{
+    ListNode_t *nNode;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    nNode = _node_new(list, data);
+
+    List_Lock(list);
+    {
+        _link_next(node, nNode);
+        if (node == list->tail) _list_store(list->tail, nNode);
+        _list_store(list->length, list->length + 1);
+
+        _list_on_link(list, nNode);
+    }
+    List_UnLock(list);
+
+    return nNode;
+}
+
+ListNode_t *List_InsertNodeBefore(List_t *list, ListNode_t *node, void *data)
+{
+    ListNode_t *nNode;
+
+    if (list->intrusive) {
+        return NULL;
+    }
+
+    nNode = _node_new(list, data);
+
+    List_Lock(list);
+    {
+        if (node == list->head) {
+            // link it before publishing the new head, the lock-free readers may load it at once
+            nNode->next = node;
+            node->prev  = nNode;
+            _list_store(list->head, nNode);
+        } else {
+            _link_next(node->prev, nNode);
+        }
+
+        _list_store(list->length, list->length + 1);
+
+        _list_on_link(list, nNode);
+    }
+    List_UnLock(list);
+
+    return nNode;
+}
+
+ListNode_t *List_RemoveNode(List_t *list, ListNode_t *node)
+{
+    ListNode_t *n;
+    List_Lock(list);
+    n = _list_remove_node(list, node);
+    List_UnLock(list);
+    return n;
+}
+
+void *List_DeleteNode2(List_t *list, ListNode_t *node, bool free_user_data)
+{
+    void *usr_data = NULL;
+
+    List_Lock(list);
+    {
+        node = _list_remove_node(list, node);
+
+        if (node) {
+
+            if (!free_user_data) {
+                usr_data = node->data;
+            }
+
+            _node_release(list, node, free_user_data);
+            _list_collect(list);
+        }
+
+        else {
+            // it's an invalid node, ignore it
+        }
+    }
+    List_UnLock(list);
+
+    return usr_data;
+}
+
+void List_DeleteNode(List_t *list, ListNode_t *node)
+{
+    List_DeleteNode2(list, node, true);
+}
+
+void List_DeleteMatched(List_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    List_Filter(list, matcher, params, NULL);
+}
+
+uint32_t List_Filter(List_t *list, ListNodeMatcher_t matcher, void *params,
+                     ListBatchDestructor_t batchDestructor)
+{
+    ListNode_t *first, *last;
+    uint32_t n;
+
+    List_Lock(list);
+    {
+        n = _list_unlink_matched(list, matcher, params, true, &first, &last);
+        _list_collect(list);
+    }
+    List_UnLock(list);
+
+#ifndef LIST_EPOCH_RECLAIM
+    // the removed nodes are not reachable from the list, destroy them without the lock
+    if (n > 0) _chain_destroy(list, first, last, n, batchDestructor);
+#else
+    (void)batchDestructor;
+#endif
+
+    return n;
+}
+
+uint32_t List_Partition(List_t *list, ListNodeMatcher_t matcher, void *params, List_t *dst)
+{
+    ListNode_t *first, *last;
+    uint32_t n = 0;
+
+    if (list == dst || !_list_same_alloc(list, dst)) {
+        return 0;
+    }
+
+    _list_exclude_readers(list);
+    _list_lock_pair(list, dst);
+    {
+        n = _list_unlink_matched(list, matcher, params, false, &first, &last);
+
+        if (n > 0) {
+            _list_insert_chain(dst, dst->tail, first, last, n);
+        }
+    }
+    _list_unlock_pair(list, dst);
+    _list_admit_readers(list);
+
+    return n;
+}
+
+uint32_t List_Count(List_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    uint32_t count = 0, ticket;
+    ListNode_t *node;
+
+    ticket = List_EpochEnter(list);
+    {
+        for (node = _list_load(list->head); node != NULL; node = _link_load(node->next)) {
+            if (matcher(node->data, params)) count++;
+        }
+    }
+    List_EpochExit(list, ticket);
+
+    return count;
+}
+
+void List_CountMany(List_t *list, ListNodeMatcher_t *matchers, void **params,
+                    uint32_t n, uint32_t *counts)
+{
+    uint32_t i, ticket;
+    ListNode_t *node;
+
+    for (i = 0; i < n; i++) {
+        counts[i] = 0;
+    }
+
+    ticket = List_EpochEnter(list);
+    {
+        for (node = _list_load(list->head); node != NULL; node = _link_load(node->next)) {
+            for (i = 0; i < n; i++) {
+                if (matchers[i](node->data, params == NULL ? NULL : params[i])) counts[i]++;
+            }
+        }
+    }
+    List_EpochExit(list, ticket);
+}
+
+bool List_IsEmpty(List_t *list)
+{
+    uint32_t len;
+    List_LockField(list);
+    len = _list_load(list->length);
+    List_UnLockField(list);
+    return len == 0;
+}
+
+void List_Traverse(List_t *list, ListVisitor_t visitor, void *params, bool isReverse)
+{
+    ListNode_t *current;
+    uint32_t ticket;
+
+    if (isReverse) {
+
+        // the 'prev' links of removed nodes are not kept, so take the lock
+        List_LockShared(list);
+        {
+            current = list->tail;
+
+            while (current != NULL) {
+                if (!visitor(current->data, params)) break;
+                current = current->prev;
+            }
+        }
+        List_UnLockShared(list);
+
+    } else {
+
+        ticket = List_EpochEnter(list);
+        {
+            current = _list_load(list->head);
+
+            while (current != NULL) {
+                if (!visitor(current->data, params)) break;
+                current = _link_load(current->next);
+            }
+        }
+        List_EpochExit(list, ticket);
+    }
+}
+
+uint32_t List_EpochEnter(List_t *list)
+{
+#ifdef LIST_EPOCH_RECLAIM
+    uint32_t i, n, v, nv, e, start;
+    bool nested = _epoch_is_held(list);
+
+    // spread the threads over the slots by their stack address
+    start = (uint32_t)((uintptr_t)&start >> 6) % LIST_EPOCH_READERS;
+
+    for (;;) {
+
+        e = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST) & _EPOCH_MASK;
+
+        for (n = 0;; n++) {
+
+            i = (start + n) % LIST_EPOCH_READERS;
+            v = __atomic_load_n(&list->readers[i], __ATOMIC_RELAXED);
+
+            // take a free slot or share a slot of current epoch,
+            // if all slots are busy, share any of them (an older epoch is always safe)
+            if ((v & _EPOCH_COUNT_MASK) == 0) {
+                nv = (e << _EPOCH_COUNT_BITS) | 1;
+            } else if (((v >> _EPOCH_COUNT_BITS) == e || n >= LIST_EPOCH_READERS) &&
+                       (v & _EPOCH_COUNT_MASK) != _EPOCH_COUNT_MASK) {
+                nv = v + 1;
+            } else {
+                continue;
+            }
+
+            if (__atomic_compare_exchange_n(&list->readers[i], &v, nv, false,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+
+        // make the slot visible before reading the list
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if (nested || __atomic_load_n(&list->excluders, __ATOMIC_SEQ_CST) == 0) {
+            break;
+        }
+
+        // a writer is relinking the nodes, give back the slot and wait for it
+        __atomic_fetch_sub(&list->readers[i], 1, __ATOMIC_RELEASE);
+
+        while (__atomic_load_n(&list->excluders, __ATOMIC_ACQUIRE) != 0) {
+            List_EpochPause();
+        }
+    }
+
+    _epoch_hold(list);
+
+    return i;
+#else
+    (void)list;
+    List_LockShared(list);
+    return 0;
+#endif
+}
+
+void List_EpochExit(List_t *list, uint32_t ticket)
+{
+#ifdef LIST_EPOCH_RECLAIM
+    _epoch_unhold(list);
+    __atomic_fetch_sub(&list->readers[ticket], 1, __ATOMIC_RELEASE);
+#else
+    (void)list;
+    (void)ticket;
+    List_UnLockShared(list);
+#endif
+}
+
+void List_EpochReclaim(List_t *list)
+{
+#ifdef LIST_EPOCH_RECLAIM
+    List_Lock(list);
+    {
+        // the nodes of current epoch are freed after 2 steps
+        if (_epoch_advance(list)) _epoch_advance(list);
+    }
+    List_UnLock(list);
+#else
+    (void)list;
+#endif
+}
+
+//----------------------- merge sort ---------------------------
+
+// merge two sorted chains (linked by 'next' and end with NULL), stable
+static ListNode_t *_merge_chain(ListNode_t *left, ListNode_t *right, ListNodeComparer_t comparer)
+{
+    ListNode_t head, *tail = &head;
+
+    while (left != NULL && right != NULL) {
+        if (comparer(left->data, right->data) <= 0) {
+            tail->next = left;
+            left       = left->next;
+        } else {
+            tail->next = right;
+            right      = right->next;
+        }
+        tail = tail->next;
+    }
+
+    tail->next = left != NULL ? left : right;
+
+    return head.next;
+}
+
+// bottom-up merge sort a chain (linked by 'next' and end with NULL),
+// the bin[i] holds a sorted chain of 2^i nodes, so we don't need any heap memory
+static ListNode_t *_merge_sort_chain(ListNode_t *chain, ListNodeComparer_t comparer)
+{
+    ListNode_t *bins[_SORT_BINS], *carry;
+    uint32_t i;
+
+    for (i = 0; i < _SORT_BINS; i++) {
+        bins[i] = NULL;
+    }
+
+    while (chain != NULL) {
+
+        carry       = chain;
+        chain       = chain->next;
+        carry->next = NULL;
+
+        // the older nodes are always on the left side, keep it stable
+        for (i = 0; i < _SORT_BINS - 1 && bins[i] != NULL; i++) {
+            carry   = _merge_chain(bins[i], carry, comparer);
+            bins[i] = NULL;
+        }
+
+        bins[i] = bins[i] == NULL ? carry : _merge_chain(bins[i], carry, comparer);
+    }
+
+    carry = NULL;
+
+    for (i = 0; i < _SORT_BINS; i++) {
+        if (bins[i] != NULL) {
+            carry = carry == NULL ? bins[i] : _merge_chain(bins[i], carry, comparer);
+        }
+    }
+
+    return carry;
 }
 
-ListNode_t *List_RemoveNode(List_t *list, ListNode_t *node)
+// set a sorted chain as the list content, rebuild the 'prev' links and the tail
+static void _list_relink_chain(List_t *list, ListNode_t *first)
 {
-    ListNode_t *n;
+    ListNode_t *node, *prev = NULL;
+
+    for (node = first; node != NULL; node = node->next) {
+        node->prev = prev;
+        prev       = node;
+    }
+
+    _list_store(list->head, first);
+    _list_store(list->tail, prev);
+
+    _list_on_reorder(list);
+}
+
+void List_MergeSort(List_t *list, ListNodeComparer_t comparer)
+{
+    _list_exclude_readers(list);
     List_Lock(list);
-    n = _list_remove_node(list, node);
+    {
+        if (list->length > 1) {
+            _list_relink_chain(list, _merge_sort_chain(list->head, comparer));
+        }
+    }
     List_UnLock(list);
-    return n;
+    _list_admit_readers(list);
 }
 
-void *List_DeleteNode2(List_t *list, ListNode_t *node, bool free_user_data)
+//----------------------- natural merge sort ---------------------------
+
+typedef struct {
+    ListNode_t *first;
+    ListNode_t *last;
+    uint32_t length;
+} _sort_run;
+
+// find the last node which is 'before' the key in a sorted chain
+// (isLessEqual: node <= key, otherwise: node < key),
+// the 'first' node must be known 'before' the key.
+// The nodes are probed at 1, 2, 4, 8 ... steps, so we only need O(log(k)) comparisons
+static ListNode_t *_gallop(ListNode_t *first, void *key, bool isLessEqual,
+                           ListNodeComparer_t comparer, uint32_t *taken)
 {
-    void *usr_data = NULL;
+    ListNode_t *lo = first, *probe;
+    uint32_t step = 1, dist, half;
+    int res;
 
-    List_Lock(list);
-    {
-        node = _list_remove_node(list, node);
+    *taken = 1;
 
-        if (node) {
+    // exponential search
+    for (;;) {
 
-            if (free_user_data) {
-                list->destructor(node->data);
-            } else {
-                usr_data = node->data;
-            }
+        probe = lo;
+        for (dist = 0; dist < step && probe->next != NULL; dist++) {
+            probe = probe->next;
+        }
 
-            List_mem_free(node);
+        if (dist == 0) {
+            return lo; // end of the chain
         }
 
-        else {
-            // it's an invalid node, ignore it
+        res = comparer(probe->data, key);
+
+        if (isLessEqual ? res <= 0 : res < 0) {
+            lo = probe;
+            step *= 2;
+            *taken += dist;
+        } else {
+            break;
         }
     }
-    List_UnLock(list);
 
-    return usr_data;
+    // binary search in (lo, probe)
+    dist--;
+
+    while (dist > 0) {
+
+        half  = (dist + 1) / 2;
+        probe = lo;
+        for (step = 0; step < half; step++) {
+            probe = probe->next;
+        }
+
+        res = comparer(probe->data, key);
+
+        if (isLessEqual ? res <= 0 : res < 0) {
+            lo = probe;
+            dist -= half;
+            *taken += half;
+        } else {
+            dist = half - 1;
+        }
+    }
+
+    return lo;
 }
 
-void List_DeleteNode(List_t *list, ListNode_t *node)
+// galloping pays off only when it takes many nodes at once,
+// otherwise make it harder to enter the galloping mode
+static List_Inline uint32_t _gallop_adjust(uint32_t minGallop, uint32_t taken)
 {
-    List_DeleteNode2(list, node, true);
+    if (taken >= _SORT_MIN_GALLOP) {
+        return minGallop > 1 ? minGallop - 1 : 1;
+    }
+
+    return minGallop + 2;
 }
 
-void List_DeleteMatched(List_t *list, ListNodeMatcher_t matcher, void *params)
+// merge two adjacent runs (left is before right), stable
+static void _merge_run(_sort_run *left, _sort_run *right, ListNodeComparer_t comparer)
 {
-    ListNode_t *current, *n;
+    ListNode_t head, *tail = &head, *l = left->first, *r = right->first, *last;
+    uint32_t lCnt = 0, rCnt = 0, minGallop = _SORT_MIN_GALLOP, taken;
+
+    // already in order, just concatenate them
+    if (comparer(left->last->data, r->data) <= 0) {
+        left->last->next = r;
+        left->last       = right->last;
+        left->length += right->length;
+        return;
+    }
 
-    List_Lock(list);
-    {
-        current = list->head;
+    while (l != NULL && r != NULL) {
 
-        while (current != NULL) {
+        if (comparer(l->data, r->data) <= 0) {
 
-            if (matcher(current->data, params)) {
-                n       = current->next;
-                current = _list_remove_node(list, current);
-                list->destructor(current->data);
-                List_mem_free(current);
-                current = n;
+            if (++lCnt >= minGallop) {
+                last       = _gallop(l, r->data, true, comparer, &taken);
+                minGallop  = _gallop_adjust(minGallop, taken);
+                tail->next = l;
+                tail       = last;
+                l          = last->next;
+                lCnt       = 0;
+            } else {
+                tail->next = l;
+                tail       = l;
+                l          = l->next;
             }
 
-            else {
-                current = current->next;
+            rCnt = 0;
+
+        } else {
+
+            if (++rCnt >= minGallop) {
+                last       = _gallop(r, l->data, false, comparer, &taken);
+                minGallop  = _gallop_adjust(minGallop, taken);
+                tail->next = r;
+                tail       = last;
+                r          = last->next;
+                rCnt       = 0;
+            } else {
+                tail->next = r;
+                tail       = r;
+                r          = r->next;
             }
+
+            lCnt = 0;
         }
     }
-    List_UnLock(list);
+
+    if (l != NULL) {
+        tail->next = l;
+        tail       = left->last;
+    } else {
+        tail->next = r;
+        tail       = right->last;
+    }
+
+    left->first = head.next;
+    left->last  = tail;
+    left->length += right->length;
 }
 
-uint32_t List_Count(List_t *list, ListNodeMatcher_t matcher, void *params)
+// cut a run from the chain, a strictly descending run will be reversed
+static ListNode_t *_take_run(ListNode_t *chain, _sort_run *run, ListNodeComparer_t comparer)
 {
-    uint32_t count = 0;
-    ListNode_t *node;
+    ListNode_t *node = chain, *next, *prev;
 
-    List_Lock(list);
-    {
-        node = _list_find_first(list, matcher, params);
+    run->first  = chain;
+    run->length = 1;
 
-        if (node == NULL) {
-            List_UnLock(list);
-            return count;
+    if (node->next != NULL && comparer(node->data, node->next->data) > 0) {
+
+        // descending, reverse it in place
+        prev = NULL;
+        while (node->next != NULL && comparer(node->data, node->next->data) > 0) {
+            next       = node->next;
+            node->next = prev;
+            prev       = node;
+            node       = next;
+            run->length++;
         }
 
-        count++;
+        next       = node->next;
+        node->next = prev;
+        run->last  = chain;
+        run->first = node;
 
-        do {
-            if (matcher(node->data, params)) count++;
+    } else {
+
+        while (node->next != NULL && comparer(node->data, node->next->data) <= 0) {
             node = node->next;
-        } while (node != NULL);
+            run->length++;
+        }
+
+        next      = node->next;
+        run->last = node;
     }
-    List_UnLock(list);
 
-    return count;
+    run->last->next = NULL;
+
+    return next;
 }
 
-bool List_IsEmpty(List_t *list)
+void List_NaturalSort(List_t *list, ListNodeComparer_t comparer)
 {
-    uint32_t len;
+    _sort_run stack[_SORT_MAX_RUNS];
+    ListNode_t *chain;
+    uint32_t n = 0, i;
+
+    _list_exclude_readers(list);
     List_Lock(list);
-    len = list->length;
+    {
+        if (list->length < 2) {
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return;
+        }
+
+        chain = list->head;
+
+        while (chain != NULL) {
+
+            chain = _take_run(chain, &stack[n++], comparer);
+
+            // keep the timsort invariants, so the run lengths on the stack
+            // grow at least as fast as fibonacci numbers
+            while (n > 1) {
+
+                i = n - 2;
+
+                if ((n > 2 && stack[n - 3].length <= stack[n - 2].length + stack[n - 1].length) ||
+                    (n > 3 && stack[n - 4].length <= stack[n - 3].length + stack[n - 2].length)) {
+                    if (stack[n - 3].length < stack[n - 1].length) i = n - 3;
+                } else if (stack[n - 2].length > stack[n - 1].length) {
+                    break;
+                }
+
+                _merge_run(&stack[i], &stack[i + 1], comparer);
+
+                if (i + 2 < n) stack[i + 1] = stack[i + 2];
+                n--;
+            }
+        }
+
+        while (n > 1) {
+            _merge_run(&stack[n - 2], &stack[n - 1], comparer);
+            n--;
+        }
+
+        _list_relink_chain(list, stack[0].first);
+    }
     List_UnLock(list);
-    return len == 0;
+    _list_admit_readers(list);
 }
 
-void List_Traverse(List_t *list, ListVisitor_t visitor, void *params, bool isReverse)
+//----------------------- array sort ---------------------------
+
+static List_Inline void _swap_ptr(void **p1, void **p2)
 {
-    ListNode_t *current;
+    void *t = *p1;
+    *p1     = *p2;
+    *p2     = t;
+}
 
-    List_Lock(list);
-    {
-        if (isReverse) {
+static void _array_insertion_sort(void **arr, uint32_t n, ListNodeComparer_t comparer)
+{
+    uint32_t i, j;
+    void *dat;
 
-            current = list->tail;
+    for (i = 1; i < n; i++) {
+        dat = arr[i];
+        for (j = i; j > 0 && comparer(arr[j - 1], dat) > 0; j--) {
+            arr[j] = arr[j - 1];
+        }
+        arr[j] = dat;
+    }
+}
 
-            while (current != NULL) {
-                if (!visitor(current->data, params)) break;
-                current = current->prev;
-            }
+static void _array_sift_down(void **arr, uint32_t root, uint32_t n, ListNodeComparer_t comparer)
+{
+    uint32_t child;
+
+    while ((child = 2 * root + 1) < n) {
+
+        if (child + 1 < n && comparer(arr[child], arr[child + 1]) < 0) {
+            child++;
+        }
+
+        if (comparer(arr[root], arr[child]) >= 0) {
+            break;
+        }
 
+        _swap_ptr(&arr[root], &arr[child]);
+        root = child;
+    }
+}
+
+static void _array_heap_sort(void **arr, uint32_t n, ListNodeComparer_t comparer)
+{
+    uint32_t i;
+
+    for (i = n / 2; i > 0; i--) {
+        _array_sift_down(arr, i - 1, n, comparer);
+    }
+
+    for (i = n - 1; i > 0; i--) {
+        _swap_ptr(&arr[0], &arr[i]);
+        _array_sift_down(arr, 0, i, comparer);
+    }
+}
+
+// introsort: quick sort with median-of-three pivot, fall back to heap sort
+// when the recursion is too deep, and finish the small parts by insertion sort
+static void _array_intro_sort(void **arr, uint32_t n, uint32_t depth, ListNodeComparer_t comparer)
+{
+    uint32_t i, j, mid;
+    void *pivot;
+
+    while (n > _SORT_ARRAY_THRESHOLD) {
+
+        if (depth == 0) {
+            _array_heap_sort(arr, n, comparer);
+            return;
+        }
+
+        depth--;
+
+        // median of three, and put it at arr[0]
+        mid = n / 2;
+        if (comparer(arr[mid], arr[0]) < 0) _swap_ptr(&arr[mid], &arr[0]);
+        if (comparer(arr[n - 1], arr[mid]) < 0) {
+            _swap_ptr(&arr[n - 1], &arr[mid]);
+            if (comparer(arr[mid], arr[0]) < 0) _swap_ptr(&arr[mid], &arr[0]);
+        }
+        _swap_ptr(&arr[0], &arr[mid]);
+
+        // hoare partition
+        pivot = arr[0];
+        i     = 0;
+        j     = n;
+
+        for (;;) {
+            do i++; while (i < n && comparer(arr[i], pivot) < 0);
+            do j--; while (comparer(arr[j], pivot) > 0);
+            if (i >= j) break;
+            _swap_ptr(&arr[i], &arr[j]);
+        }
+
+        _swap_ptr(&arr[0], &arr[j]);
+
+        // recurse into the smaller part, loop on the larger part
+        if (j < n - j - 1) {
+            _array_intro_sort(arr, j, depth, comparer);
+            arr += j + 1;
+            n -= j + 1;
         } else {
+            _array_intro_sort(arr + j + 1, n - j - 1, depth, comparer);
+            n = j;
+        }
+    }
 
-            current = list->head;
+    _array_insertion_sort(arr, n, comparer);
+}
 
-            while (current != NULL) {
-                if (!visitor(current->data, params)) break;
-                current = current->next;
+bool List_SortViaArray(List_t *list, ListNodeComparer_t comparer, void **buffer, uint32_t bufferSize)
+{
+    ListNode_t *node;
+    void **arr;
+    uint32_t i, depth;
+
+    _list_exclude_readers(list);
+    List_Lock(list);
+    {
+        if (list->length < 2) {
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return true;
+        }
+
+        if (buffer != NULL && bufferSize >= list->length) {
+            arr = buffer;
+        } else {
+            arr = (void **)List_mem_alloc(list->length * sizeof(void *));
+            if (arr == NULL) {
+                List_UnLock(list);
+                _list_admit_readers(list);
+                return false;
             }
         }
+
+        // gather
+        i = 0;
+        for (node = list->head; node != NULL; node = node->next) {
+            arr[i++] = node->data;
+        }
+
+        depth = 0;
+        for (i = list->length; i > 1; i >>= 1) {
+            depth += 2;
+        }
+
+        _array_intro_sort(arr, list->length, depth, comparer);
+
+        // scatter
+        i = 0;
+        for (node = list->head; node != NULL; node = node->next) {
+            node->data = arr[i++];
+        }
+
+        _list_on_data_changed(list);
+
+        if (arr != buffer) {
+            List_mem_free(arr);
+        }
     }
     List_UnLock(list);
+    _list_admit_readers(list);
+
+    return true;
 }
 
-//----------------------- quick sort ---------------------------
+//----------------------- radix sort ---------------------------
 
 typedef struct {
-    ListNode_t *first;
-    ListNode_t *last;
-} _sort_data;
+    uint64_t key;
+    ListNode_t *node;
+} _radix_item;
 
-static ListNode_t *_sort_part(ListNode_t *_first, ListNode_t *_last, ListNodeComparer_t comparer)
+bool List_RadixSort(List_t *list, ListKeyExtractor_t extractor, uint32_t keyBits)
 {
-    ListNode_t *pit = _first, *first = _first, *last = _last;
-    void *base   = _first->data;
-    bool isRight = true;
+    _radix_item *src, *dst, *tmp;
+    ListNode_t *node;
+    uint32_t counts[_RADIX_PASSES][_RADIX_BUCKETS];
+    uint32_t i, pass, passes, digit, sum, cnt;
+    uint64_t mask;
 
-    while (first != last) {
-        if (isRight) {
-            if (comparer(base, last->data) >= 0) {
-                _set_node(pit, last->data);
-                pit     = last;
-                isRight = false;
-                first   = first->next;
-            } else {
-                last = last->prev;
+    if (keyBits == 0 || keyBits > 64) {
+        return false;
+    }
+
+    passes = (keyBits + _RADIX_BITS - 1) / _RADIX_BITS;
+    mask   = keyBits < 64 ? ((uint64_t)1 << keyBits) - 1 : ~(uint64_t)0;
+
+    _list_exclude_readers(list);
+    List_Lock(list);
+    {
+        if (list->length < 2) {
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return true;
+        }
+
+        src = (_radix_item *)List_mem_alloc(2 * list->length * sizeof(_radix_item));
+
+        if (src == NULL) {
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return false;
+        }
+
+        dst = src + list->length;
+
+        for (pass = 0; pass < passes; pass++) {
+            for (digit = 0; digit < _RADIX_BUCKETS; digit++) {
+                counts[pass][digit] = 0;
             }
-        } else {
-            if (comparer(first->data, base) > 0) {
-                _set_node(pit, first->data);
-                pit     = first;
-                isRight = true;
-                last    = last->prev;
-            } else {
-                first = first->next;
+        }
+
+        // extract the keys only once, and count all digits at the same time
+        i = 0;
+        for (node = list->head; node != NULL; node = node->next) {
+
+            src[i].key  = extractor(node->data) & mask; // the last pass may cover the unused bits
+            src[i].node = node;
+
+            for (pass = 0; pass < passes; pass++) {
+                counts[pass][(src[i].key >> (pass * _RADIX_BITS)) & (_RADIX_BUCKETS - 1)]++;
+            }
+
+            i++;
+        }
+
+        for (pass = 0; pass < passes; pass++) {
+
+            // all keys have the same digit, skip this pass
+            digit = (src[0].key >> (pass * _RADIX_BITS)) & (_RADIX_BUCKETS - 1);
+            if (counts[pass][digit] == list->length) {
+                continue;
+            }
+
+            sum = 0;
+            for (digit = 0; digit < _RADIX_BUCKETS; digit++) {
+                cnt                 = counts[pass][digit];
+                counts[pass][digit] = sum;
+                sum += cnt;
             }
+
+            for (i = 0; i < list->length; i++) {
+                digit = (src[i].key >> (pass * _RADIX_BITS)) & (_RADIX_BUCKETS - 1);
+                dst[counts[pass][digit]++] = src[i];
+            }
+
+            tmp = src;
+            src = dst;
+            dst = tmp;
+        }
+
+        // relink nodes in order
+        for (i = 0; i + 1 < list->length; i++) {
+            src[i].node->next = src[i + 1].node;
         }
+
+        src[i].node->next = NULL;
+
+        _list_relink_chain(list, src[0].node);
+
+        List_mem_free(src < dst ? src : dst);
     }
+    List_UnLock(list);
+    _list_admit_readers(list);
+
+    return true;
+}
 
-    _set_node(first, base);
+//----------------------- parallel sort ---------------------------
 
-    return first;
+#ifdef LIST_PARALLEL_SORT
+
+typedef struct {
+    ListNode_t *left;
+    ListNode_t *right;
+    ListNodeComparer_t comparer;
+} _sort_task;
+
+static void _sort_task_entry(void *arg)
+{
+    _sort_task *task = (_sort_task *)arg;
+
+    if (task->right == NULL) {
+        task->left = _merge_sort_chain(task->left, task->comparer);
+    } else {
+        task->left = _merge_chain(task->left, task->right, task->comparer);
+    }
 }
 
-void List_QuickSort(List_t *list, ListNodeComparer_t comparer)
+// run the tasks on worker threads, the first task will be run on current thread
+// (and also the tasks whose thread can't be started)
+static void _sort_task_run(_sort_task *tasks, uint32_t n)
 {
-    List_t *stack      = List_CreateList(NULL);
-    _sort_data *nsData = NULL, *sData = NULL;
-    ListNode_t *node = NULL, *middle = NULL;
+    void *threads[_PARALLEL_MAX_THREADS];
+    uint32_t i;
 
-    List_Lock(list);
+    for (i = 1; i < n; i++) {
+        threads[i] = List_ThreadNew(_sort_task_entry, &tasks[i]);
+    }
 
-    nsData        = (_sort_data *)List_mem_alloc(sizeof(_sort_data));
-    nsData->first = list->head;
-    nsData->last  = list->tail;
+    _sort_task_entry(&tasks[0]);
 
-    if (nsData->first == nsData->last) {
-        List_mem_free(nsData);
-        List_UnLock(list);
-        return;
+    for (i = 1; i < n; i++) {
+        if (threads[i] == NULL) {
+            _sort_task_entry(&tasks[i]);
+        } else {
+            List_ThreadJoin(threads[i]);
+        }
+    }
+}
+
+void List_ParallelSort(List_t *list, ListNodeComparer_t comparer, uint32_t threads)
+{
+    _sort_task tasks[_PARALLEL_MAX_THREADS];
+    ListNode_t *node, *next;
+    uint32_t i, j, n, segSize;
+
+    if (threads > _PARALLEL_MAX_THREADS) {
+        threads = _PARALLEL_MAX_THREADS;
     }
 
-    List_Push(stack, nsData);
+    _list_exclude_readers(list);
+    List_Lock(list);
+    {
+        if (list->length < 2) {
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return;
+        }
+
+        // it's not worth to start threads for a small list
+        if (threads < 2 || list->length / threads < _PARALLEL_MIN_SEGMENT) {
+            _list_relink_chain(list, _merge_sort_chain(list->head, comparer));
+            List_UnLock(list);
+            _list_admit_readers(list);
+            return;
+        }
 
-    while (!List_IsEmpty(stack)) {
+        // split the list into segments
+        segSize = list->length / threads;
+        node    = list->head;
 
-        node  = List_Pop(stack);
-        sData = node->data;
+        for (i = 0; i < threads; i++) {
 
-        if (sData->first->next != sData->last) {
+            tasks[i].left     = node;
+            tasks[i].right    = NULL;
+            tasks[i].comparer = comparer;
 
-            middle = _sort_part(sData->first, sData->last, comparer);
+            if (i == threads - 1) {
+                break;
+            }
 
-            // right
-            if (middle != sData->last) {
-                nsData        = (_sort_data *)List_mem_alloc(sizeof(_sort_data));
-                nsData->first = middle->next;
-                nsData->last  = sData->last;
-                List_Push(stack, nsData);
+            for (j = 1; j < segSize; j++) {
+                node = node->next;
             }
 
-            // left
-            if (middle != sData->first) {
-                nsData        = (_sort_data *)List_mem_alloc(sizeof(_sort_data));
-                nsData->first = sData->first;
-                nsData->last  = middle->prev;
-                List_Push(stack, nsData);
+            next       = node->next;
+            node->next = NULL;
+            node       = next;
+        }
+
+        // sort every segment
+        _sort_task_run(tasks, threads);
+
+        // merge the neighbour segments in pairs, until there is only one segment
+        for (n = threads; n > 1; n = (n + 1) / 2) {
+
+            for (i = 0; i < n / 2; i++) {
+                tasks[i].left  = tasks[2 * i].left;
+                tasks[i].right = tasks[2 * i + 1].left;
             }
-        } else {
-            if (comparer(sData->first->data, sData->last->data) > 0) {
-                _swap_node(sData->first, sData->last);
+
+            _sort_task_run(tasks, n / 2);
+
+            // the odd one is merged in next round
+            if (n % 2 != 0) {
+                tasks[n / 2].left = tasks[n - 1].left;
             }
         }
 
-        List_mem_free(sData);
-        List_mem_free(node);
+        _list_relink_chain(list, tasks[0].left);
     }
+    List_UnLock(list);
+    _list_admit_readers(list);
+}
 
-    List_mem_free(stack);
+#endif
 
-    List_UnLock(list);
+void List_QuickSort(List_t *list, ListNodeComparer_t comparer)
+{
+    List_MergeSort(list, comparer);
 }
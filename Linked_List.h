@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 //
 // list config
@@ -57,8 +58,52 @@
 #define List_mem_free free
 #endif
 
+#ifndef LIST_NODE_POOL_CHUNK_SIZE
+#define LIST_NODE_POOL_CHUNK_SIZE 64
+#endif
+
+// the slab size of a node pool doubles until this limit (in nodes),
+// define it as 'LIST_NODE_POOL_CHUNK_SIZE' to use fixed size slabs
+#ifndef LIST_NODE_POOL_MAX_CHUNK_SIZE
+#define LIST_NODE_POOL_MAX_CHUNK_SIZE 4096
+#endif
+
 #ifdef LIST_THREAD_SAFED
 
+#ifdef LIST_RWLOCK
+
+/**
+ * Use reader/writer lock instead of mutex,
+ * the read-only functions (List_Traverse, List_FindFirst, List_Count, List_Length ...)
+ * will take a shared lock, so they can run in parallel, only the mutations are serialized
+ */
+
+#ifndef List_RwLockNew
+#error "We need 'List_RwLockNew' in os !"
+#endif
+
+#ifndef List_RwLockFree
+#error "We need 'List_RwLockFree' in os !"
+#endif
+
+#ifndef List_RwLockAcquireShared
+#error "We need 'List_RwLockAcquireShared' in os !"
+#endif
+
+#ifndef List_RwLockReleaseShared
+#error "We need 'List_RwLockReleaseShared' in os !"
+#endif
+
+#ifndef List_RwLockAcquireExclusive
+#error "We need 'List_RwLockAcquireExclusive' in os !"
+#endif
+
+#ifndef List_RwLockReleaseExclusive
+#error "We need 'List_RwLockReleaseExclusive' in os !"
+#endif
+
+#else
+
 #ifndef List_MutexNew
 #error "We need 'List_MutexNew' in os !"
 #endif
@@ -75,6 +120,133 @@
 #error "We need 'List_MutexRelease' in os !"
 #endif
 
+#ifdef LIST_BLOCKING_QUEUE
+
+/**
+ * Blocking queue: 'List_EnqueueWait', 'List_DequeueWait', 'List_SetCapacity', 'List_Close'
+ *
+ * void *List_CondNew(void);
+ *  create a condition variable
+ *
+ * void List_CondFree(void *cond);
+ *  destroy a condition variable
+ *
+ * bool List_CondWait(void *cond, void *mutex, uint32_t timeout);
+ *  release the mutex (created by 'List_MutexNew') and wait for a signal, then re-acquire the mutex,
+ *  'timeout' is in milliseconds ('LIST_WAIT_FOREVER' means no timeout), return false if timeout
+ *
+ * void List_CondSignal(void *cond);
+ *  wake up one waiting thread
+ *
+ * void List_CondBroadcast(void *cond);
+ *  wake up all waiting threads
+ */
+
+#ifndef List_CondNew
+#error "We need 'List_CondNew' in os !"
+#endif
+
+#ifndef List_CondFree
+#error "We need 'List_CondFree' in os !"
+#endif
+
+#ifndef List_CondWait
+#error "We need 'List_CondWait' in os !"
+#endif
+
+#ifndef List_CondSignal
+#error "We need 'List_CondSignal' in os !"
+#endif
+
+#ifndef List_CondBroadcast
+#error "We need 'List_CondBroadcast' in os !"
+#endif
+
+#endif
+
+#endif
+
+/**
+ * List_AtomicLoad(ptr) / List_AtomicStore(ptr, val):
+ *  acquire load and release store for a pointer-sized (or smaller) field,
+ *  if they are available, 'List_Length', 'List_IsEmpty', 'List_First', 'List_Last' will not take the lock
+ */
+#if !defined(List_AtomicLoad) && (defined(__GNUC__) || defined(__clang__))
+#define List_AtomicLoad(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define List_AtomicStore(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#endif
+
+#ifdef LIST_EPOCH_RECLAIM
+
+/**
+ * Epoch based reclamation:
+ *  the forward read-only functions (List_Traverse, List_FindFirst, List_FindNext, List_Count)
+ *  will not take any lock, so the readers never block the writers;
+ *  the removed nodes keep their 'next' link, and the data destructor and node free
+ *  are deferred until all readers which may still see these nodes have left
+ *  the functions which relink the nodes (the sorts, 'List_Partition', 'List_Splice', 'List_Concat',
+ *  'List_SplitAt', 'List_DequeueList') wait for the lock-free readers of the source list to leave,
+ *  and the new readers wait until they are done
+ *  (!!! so don't call them in a read-side section or a traverse visitor of the same list !!!)
+ *
+ * LIST_EPOCH_READERS: the number of reader slots of a list,
+ *  the concurrent readers more than this will share the slots
+ *
+ * LIST_EPOCH_NESTING: the max depth of the nested read-side sections of a thread,
+ *  (!!! the deeper sections may wait for the relinking writers, which wait for the outer sections !!!)
+ *
+ * List_EpochPause():
+ *  called in the spin loops of the waiting readers and writers, e.g. 'sched_yield()'
+ */
+
+#if !defined(__GNUC__) && !defined(__clang__)
+#error "We need gcc '__atomic' builtins for 'LIST_EPOCH_RECLAIM' !"
+#endif
+
+#ifndef LIST_EPOCH_READERS
+#define LIST_EPOCH_READERS 32
+#endif
+
+#ifndef LIST_EPOCH_NESTING
+#define LIST_EPOCH_NESTING 8
+#endif
+
+#ifndef List_EpochPause
+#define List_EpochPause()
+#endif
+
+#endif
+
+#elif defined(LIST_EPOCH_RECLAIM)
+#error "'LIST_EPOCH_RECLAIM' need 'LIST_THREAD_SAFED' !"
+#endif
+
+#if defined(LIST_BLOCKING_QUEUE) && (!defined(LIST_THREAD_SAFED) || defined(LIST_RWLOCK))
+#error "'LIST_BLOCKING_QUEUE' need 'LIST_THREAD_SAFED' with mutex (not 'LIST_RWLOCK') !"
+#endif
+
+// wait without timeout
+#define LIST_WAIT_FOREVER 0xFFFFFFFFu
+
+#ifdef LIST_PARALLEL_SORT
+
+/**
+ * void *List_ThreadNew(void (*entry)(void *arg), void *arg);
+ *  start a thread to run 'entry(arg)' and return the thread handle,
+ *  if the thread can't be started, return NULL and the task will be run on current thread
+ *
+ * void List_ThreadJoin(void *thread);
+ *  wait for the thread to exit and release the thread handle
+ */
+
+#ifndef List_ThreadNew
+#error "We need 'List_ThreadNew' in os !"
+#endif
+
+#ifndef List_ThreadJoin
+#error "We need 'List_ThreadJoin' in os !"
+#endif
+
 #endif
 
 //
@@ -89,6 +261,8 @@ typedef struct _ListNode {
 
 typedef struct List_t List_t;
 
+typedef struct ListNodePool_t ListNodePool_t;
+
 //
 // callback function type
 //
@@ -105,6 +279,24 @@ typedef struct List_t List_t;
  */
 typedef int (*ListNodeComparer_t)(void *dat1, void *dat2);
 
+/**
+ * @brief A Key Extractor Callbk for 'List_RadixSort(...)'
+ *
+ * @param dat The data pointer
+ *
+ * @return The unsigned integer key of the data
+ */
+typedef uint64_t (*ListKeyExtractor_t)(void *dat);
+
+/**
+ * @brief A Data Hasher Callbk for 'List_CreateIndex(...)'
+ *
+ * @param dat The data pointer (or the key pointer passed to 'List_FindByKey(...)')
+ *
+ * @return The hash value of the data key
+ */
+typedef uint32_t (*ListDataHasher_t)(void *dat);
+
 /**
  * @brief A List Node Matcher Callbk
  *
@@ -124,6 +316,16 @@ typedef bool (*ListNodeMatcher_t)(void *dat, void *params);
  */
 typedef void (*ListDataDestructor_t)(void *dat);
 
+/**
+ * @brief A Batch Data Destructor Callbk for 'List_Filter(...)'
+ *
+ * @param data The data pointers which will be freed
+ * @param n The number of data pointers
+ *
+ * @return none
+ */
+typedef void (*ListBatchDestructor_t)(void **data, size_t n);
+
 /**
  * @brief A Visitor Callbk for 'List_Traverse(...)'
  *
@@ -146,10 +348,41 @@ typedef bool (*ListVisitor_t)(void *dat, void *params);
  *                   If this params is NULL, we will use default destructor
  *                   (!!! default destructor will do nothing for your data !!!)
  *
- * @return List_t* A list
+ * @return List_t* A list, if there is no memory, return NULL
  */
 List_t *List_CreateList(ListDataDestructor_t destructor);
 
+/**
+ * @brief Create list, the nodes of this list will be allocated from a node pool
+ *
+ * @note Lists which share a same node pool can exchange nodes with each other
+ *
+ * @param destructor A data destructor callback function (same as 'List_CreateList')
+ * @param pool A node pool created by 'List_CreateNodePool';
+ *             If this params is NULL, we will create a private node pool for this list,
+ *             and the whole pool will be released by 'List_DestroyList'
+ *             (!!! all nodes of this list will be invalid after the list destroyed !!!);
+ *             The lists made from it by 'List_DequeueList', 'List_SplitAt' share the private pool,
+ *             the pool is released when the last of them is destroyed
+ *
+ * @return List_t* A list, if there is no memory (for the list or its private pool), return NULL
+ */
+List_t *List_CreateListWithPool(ListDataDestructor_t destructor, ListNodePool_t *pool);
+
+/**
+ * @brief Create an intrusive list, the nodes are embedded in user structs
+ *        and the list will never allocate or free any node
+ *
+ * @note !!! Only use 'List_PushIntrusive', 'List_PrependIntrusive' to add nodes into this list !!!
+ *       'List_Clear', 'List_DeleteNode', ... will unlink the nodes and call the destructor,
+ *       the destructor can use 'List_Entry' to free the user struct
+ *
+ * @param destructor A data destructor callback function (same as 'List_CreateList')
+ *
+ * @return List_t* A list, if there is no memory, return NULL
+ */
+List_t *List_CreateIntrusiveList(ListDataDestructor_t destructor);
+
 /**
  * @brief Destroy list
  *
@@ -157,6 +390,25 @@ List_t *List_CreateList(ListDataDestructor_t destructor);
  */
 void List_DestroyList(List_t *list);
 
+/**
+ * @brief Create a node pool (a slab allocator for 'ListNode_t')
+ *
+ * @param chunk_size The number of nodes in the first slab, if 0, use 'LIST_NODE_POOL_CHUNK_SIZE'
+ *                   (the later slabs will be larger, up to 'LIST_NODE_POOL_MAX_CHUNK_SIZE')
+ *
+ * @return ListNodePool_t* A node pool, if there is no memory, return NULL
+ */
+ListNodePool_t *List_CreateNodePool(uint32_t chunk_size);
+
+/**
+ * @brief Destroy node pool and release all slabs
+ *
+ * @note !!! Destroy all lists which use this pool before destroy the pool !!!
+ *
+ * @param pool The node pool that will be freed
+ */
+void List_DestroyNodePool(ListNodePool_t *pool);
+
 /**
  * @brief Get node data
  *
@@ -167,6 +419,17 @@ void List_DestroyList(List_t *list);
 */
 #define List_GetNodeData(node, type) ((type *)((node) == List_nullptr ? List_nullptr : (node)->data))
 
+/**
+ * @brief Get the user struct which embeds a list node (for intrusive list)
+ *
+ * @param node The list node embedded in user struct
+ * @param type The user struct type
+ * @param member The name of the 'ListNode_t' member in user struct
+ *
+ * @return user struct pointer <type> *
+*/
+#define List_Entry(node, type, member) ((type *)((char *)(node) - offsetof(type, member)))
+
 /**
  * @brief Get prev node data
  *
@@ -193,7 +456,7 @@ void List_DestroyList(List_t *list);
  * @param list The target list
  * @param data A data pointer for new node
  *
- * @return ListNode_t* The new node
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
  */
 ListNode_t *List_Prepend(List_t *list, void *data);
 
@@ -203,10 +466,70 @@ ListNode_t *List_Prepend(List_t *list, void *data);
  * @param list The target list
  * @param data A data pointer for new node
  *
- * @return ListNode_t* The new node
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
  */
 ListNode_t *List_Push(List_t *list, void *data);
 
+/**
+ * @brief Push many nodes at end of a list, the nodes are linked in one step
+ *
+ * @note The new nodes are created before taking the lock (taken from the pool in one step
+ *       if the list use a node pool), then the whole chain is linked under one lock
+ *       (!!! not for intrusive list !!!)
+ *
+ * @param list The target list
+ * @param data The data pointers for new nodes, 'data[0]' will be the first new node
+ * @param n The number of data pointers
+ *
+ * @return ListNode_t* The first new node (NULL if n == 0 or it's an intrusive list)
+ */
+ListNode_t *List_PushBatch(List_t *list, void **data, uint32_t n);
+
+/**
+ * @brief Insert many nodes at front of a list, the nodes are linked in one step
+ *        (same as 'List_PushBatch')
+ *
+ * @param list The target list
+ * @param data The data pointers for new nodes, 'data[0]' will be the new first node of the list
+ * @param n The number of data pointers
+ *
+ * @return ListNode_t* The first new node (NULL if n == 0 or it's an intrusive list)
+ */
+ListNode_t *List_PrependBatch(List_t *list, void **data, uint32_t n);
+
+/**
+ * @brief Push a user embedded node at end of a list (for intrusive list)
+ *
+ * @param list The target list
+ * @param node The node embedded in user struct
+ * @param data A data pointer for the node (will be passed to matchers, visitors and destructor)
+ *
+ * @return ListNode_t* The node
+ */
+ListNode_t *List_PushIntrusive(List_t *list, ListNode_t *node, void *data);
+
+/**
+ * @brief Insert a user embedded node at front of a list (for intrusive list)
+ *
+ * @param list The target list
+ * @param node The node embedded in user struct
+ * @param data A data pointer for the node (will be passed to matchers, visitors and destructor)
+ *
+ * @return ListNode_t* The node
+ */
+ListNode_t *List_PrependIntrusive(List_t *list, ListNode_t *node, void *data);
+
+/**
+ * @brief Remove a user embedded node from a list (for intrusive list),
+ *        after removed, the node can be pushed into any intrusive list again
+ *
+ * @param list The target list
+ * @param node The node embedded in user struct
+ *
+ * @return ListNode_t* The removed node, if it's an invalid node, return NULL
+ */
+ListNode_t *List_RemoveIntrusive(List_t *list, ListNode_t *node);
+
 /**
  * @brief Pop the last node of a list
  *
@@ -222,7 +545,7 @@ ListNode_t *List_Pop(List_t *list);
  * @param list The target list
  * @param data A data pointer for new node
  *
- * @return ListNode_t* The new node
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
  */
 ListNode_t *List_Enqueue(List_t *list, void *data);
 
@@ -235,6 +558,105 @@ ListNode_t *List_Enqueue(List_t *list, void *data);
  */
 ListNode_t *List_Dequeue(List_t *list);
 
+#ifdef LIST_BLOCKING_QUEUE
+
+/**
+ * @brief Set the capacity of a list for 'List_EnqueueWait'
+ *
+ * @note The other push/insert functions don't check the capacity
+ *
+ * @param list The target list
+ * @param capacity The max number of nodes, 0 means no limit (default)
+ */
+void List_SetCapacity(List_t *list, uint32_t capacity);
+
+/**
+ * @brief Push a node at end of a list, if the list is full, wait until there is space
+ *
+ * @param list The target list
+ * @param data A data pointer for new node
+ * @param timeout The max time to wait (in milliseconds), 0 means don't wait,
+ *                'LIST_WAIT_FOREVER' means no timeout
+ *
+ * @return If false, timeout, the list has been closed or it's an intrusive list,
+ *         the data is not pushed
+ */
+bool List_EnqueueWait(List_t *list, void *data, uint32_t timeout);
+
+/**
+ * @brief Remove the first node of a list and free it, if the list is empty, wait for a new node
+ *
+ * @note The pushed nodes will wake up the waiting threads (by any push/insert function)
+ *
+ * @param list The target list
+ * @param data Receive the data pointer of the removed node
+ * @param timeout The max time to wait (in milliseconds), 0 means don't wait,
+ *                'LIST_WAIT_FOREVER' means no timeout
+ *
+ * @return If false, timeout or the list has been closed and drained
+ */
+bool List_DequeueWait(List_t *list, void **data, uint32_t timeout);
+
+/**
+ * @brief Close a list, wake up all waiting threads,
+ *        then 'List_EnqueueWait' will fail and 'List_DequeueWait' will fail after the list is drained
+ *
+ * @param list The target list
+ */
+void List_Close(List_t *list);
+
+/**
+ * @brief Check if a list is closed
+ *
+ * @param list The target list
+ *
+ * @return If true, the list is closed
+ */
+bool List_IsClosed(List_t *list);
+
+#endif
+
+/**
+ * @brief Remove up to 'max' nodes from the front of a list in one step,
+ *        the nodes are freed and their data pointers are returned
+ *
+ * @note The user data will not be freed
+ *
+ * @param list The target list
+ * @param out A buffer to receive the data pointers (in list order), it must hold 'max' pointers
+ * @param max The max number of nodes to remove
+ *
+ * @return The number of removed nodes
+ */
+uint32_t List_DequeueBatch(List_t *list, void **out, uint32_t max);
+
+/**
+ * @brief Remove up to 'max' nodes from the end of a list in one step,
+ *        the nodes are freed and their data pointers are returned (same as 'List_DequeueBatch')
+ *
+ * @param list The target list
+ * @param out A buffer to receive the data pointers ('out[0]' is the data of the last node)
+ * @param max The max number of nodes to remove
+ *
+ * @return The number of removed nodes
+ */
+uint32_t List_PopBatch(List_t *list, void **out, uint32_t max);
+
+/**
+ * @brief Move up to 'max' nodes from the front of a list into a new list,
+ *        the nodes are not copied, so it's O(1) if 'max' >= the list length, otherwise O(max)
+ *
+ * @note The new list uses the same destructor and node pool of the source list
+ *       (a private node pool is shared, it lives until the last of the lists is destroyed)
+ *       The hash index of the source list is not copied
+ *
+ * @param list The source list
+ * @param max The max number of nodes to move, use 'UINT32_MAX' to move all nodes
+ *
+ * @return List_t* A new list (it's empty if the source list is empty), if there is no memory, return NULL
+ */
+List_t *List_DequeueList(List_t *list, uint32_t max);
+
 /**
  * @brief Foreach a list
  *
@@ -358,6 +780,18 @@ bool List_IsEmpty(List_t *list);
  */
 uint32_t List_Count(List_t *list, ListNodeMatcher_t matcher, void *params);
 
+/**
+ * @brief Count the matched nodes for many matchers in one traverse
+ *
+ * @param list The target list
+ * @param matchers The node matchers, every matcher will be called for every node
+ * @param params The user context data for every matcher ('params[i]' for 'matchers[i]'), can be NULL
+ * @param n The number of matchers
+ * @param counts A buffer to receive the number of matched nodes for every matcher
+ */
+void List_CountMany(List_t *list, ListNodeMatcher_t *matchers, void **params,
+                    uint32_t n, uint32_t *counts);
+
 /**
  * @brief Insert a new node at the end of a existed node
  *
@@ -365,7 +799,7 @@ uint32_t List_Count(List_t *list, ListNodeMatcher_t matcher, void *params);
  * @param node The target existed node
  * @param data A data pointer for new node
  *
- * @return ListNode_t* The new node
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
  */
 ListNode_t *List_InsertNode(List_t *list, ListNode_t *node, void *data);
 
@@ -376,10 +810,23 @@ ListNode_t *List_InsertNode(List_t *list, ListNode_t *node, void *data);
  * @param node The target existed node
  * @param data A data pointer for new node
  *
- * @return ListNode_t* The new node
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
  */
 ListNode_t *List_InsertNodeBefore(List_t *list, ListNode_t *node, void *data);
 
+/**
+ * @brief Insert many nodes at the end of a existed node, the nodes are linked in one step
+ *        (same as 'List_PushBatch')
+ *
+ * @param list The target list
+ * @param node The target existed node
+ * @param data The data pointers for new nodes, keep the order in the list
+ * @param n The number of data pointers
+ *
+ * @return ListNode_t* The first new node (NULL if n == 0 or it's an intrusive list)
+ */
+ListNode_t *List_InsertBatch(List_t *list, ListNode_t *node, void **data, uint32_t n);
+
 /**
  * @brief Remove a node from target list (without free the node memory)
  *
@@ -390,6 +837,236 @@ ListNode_t *List_InsertNodeBefore(List_t *list, ListNode_t *node, void *data);
  */
 ListNode_t *List_RemoveNode(List_t *list, ListNode_t *node);
 
+/**
+ * @brief Move all nodes of 'src' into 'dst' after a node of 'dst', O(1)
+ *
+ * @note The nodes are not copied, the nodes can only be moved between the lists
+ *       which use the same node pool (or both not use pool) and the same intrusive mode;
+ *       If the lists have hash index, the index update costs O(n)
+ *
+ * @param dst The target list
+ * @param node The node of 'dst' which the nodes will be inserted after,
+ *             if NULL, the nodes will be inserted at front of 'dst'
+ * @param src The source list, it will be empty after splice
+ *
+ * @return If false, the two lists can't exchange nodes (or 'dst' == 'src'), nothing changed
+ */
+bool List_Splice(List_t *dst, ListNode_t *node, List_t *src);
+
+/**
+ * @brief Move all nodes of 'src' to the end of 'dst', O(1) (same as 'List_Splice')
+ *
+ * @param dst The target list
+ * @param src The source list, it will be empty after concat
+ *
+ * @return If false, the two lists can't exchange nodes (or 'dst' == 'src'), nothing changed
+ */
+bool List_Concat(List_t *dst, List_t *src);
+
+/**
+ * @brief Split a list into two lists, the target node and all nodes after it are moved into a new list
+ *        (O(k), k is the number of the moved nodes)
+ *
+ * @note The new list uses the same destructor and node pool of the source list
+ *       (a private node pool is shared, it lives until the last of the lists is destroyed)
+ *
+ * @param list The source list
+ * @param node The first node of the new list, it must be a node of the source list
+ *
+ * @return List_t* A new list (it's empty if 'node' is NULL), if there is no memory, return NULL
+ */
+List_t *List_SplitAt(List_t *list, ListNode_t *node);
+
+/**
+ * @brief Create a hash index for a list, so we can find a node by key in O(1)
+ *
+ * @note The index will be kept up to date by all list functions automatically,
+ *       If memory runs out when updating it, the index is dropped ('List_FindByKey' returns NULL),
+ *       !!! Don't change the key of the data when the data is in the list !!!
+ *
+ * @param list The target list
+ * @param hasher A data hasher, used to get the hash value of a data (or a key)
+ * @param comparer A comparer, used to check whether a data is equal to a key (return 0)
+ *
+ * @return If false, there is no memory for the index
+ */
+bool List_CreateIndex(List_t *list, ListDataHasher_t hasher, ListNodeComparer_t comparer);
+
+/**
+ * @brief Destroy the hash index of a list
+ *
+ * @param list The target list
+ */
+void List_DestroyIndex(List_t *list);
+
+/**
+ * @brief Find a node by key via the hash index
+ *
+ * @param list The target list
+ * @param key The key pointer, will be passed to the hasher and the comparer of the index
+ *
+ * @return ListNode_t* One of the matched nodes, if not found (or there is no index), return NULL
+ */
+ListNode_t *List_FindByKey(List_t *list, void *key);
+
+/**
+ * @brief Find a node by key via the hash index, and destroy the node and user data memory
+ *
+ * @param list The target list
+ * @param key The key pointer, will be passed to the hasher and the comparer of the index
+ *
+ * @return If false, not found (or there is no index)
+ */
+bool List_DeleteByKey(List_t *list, void *key);
+
+/**
+ * @brief Create a position index for a list, so 'List_At', 'List_IndexOf', 'List_InsertAt'
+ *        will be O(log(n)) instead of O(n)
+ *
+ * @note The index is a balanced tree of the nodes (in list order) and a node hash map,
+ *       it's maintained by all list operations, every insert/remove costs O(log(n)),
+ *       the relinking sort functions rebuild it in O(n);
+ *       The lists without position index don't pay any cost;
+ *       If memory runs out when updating it, the index is dropped
+ *
+ * @param list The target list
+ *
+ * @return If false, no memory to create the index
+ */
+bool List_CreatePositionIndex(List_t *list);
+
+/**
+ * @brief Destroy the position index of a list
+ *
+ * @param list The target list
+ */
+void List_DestroyPositionIndex(List_t *list);
+
+/**
+ * @brief Get the node at a position (O(log(n)) with position index, otherwise O(n))
+ *
+ * @param list The target list
+ * @param index The position of the node, start from 0
+ *
+ * @return ListNode_t* The node, NULL if 'index' >= the list length
+ */
+ListNode_t *List_At(List_t *list, uint32_t index);
+
+/**
+ * @brief Get the position of a node (O(log(n)) with position index, otherwise O(n))
+ *
+ * @param list The target list
+ * @param node The target node
+ *
+ * @return The position of the node (start from 0), 'UINT32_MAX' if the node is not in the list
+ */
+uint32_t List_IndexOf(List_t *list, ListNode_t *node);
+
+/**
+ * @brief Insert a new node at a position (O(log(n)) with position index, otherwise O(n))
+ *
+ * @param list The target list
+ * @param index The position of the new node, if 'index' >= the list length, push it at end
+ * @param data A data pointer for new node
+ *
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
+ */
+ListNode_t *List_InsertAt(List_t *list, uint32_t index, void *data);
+
+/**
+ * @brief Create a priority index for a list, then the list can be used as a priority queue
+ *        ('List_PQPeekMin', 'List_PQPopMin', 'List_PQDecreaseKey')
+ *
+ * @note The index is a binary min-heap of the nodes and a node hash map,
+ *       it's maintained by all list operations, every insert/remove costs O(log(n)),
+ *       so the nodes keep their handles, and we don't need to sort the list after pushes;
+ *       The lists without priority index don't pay any cost;
+ *       If memory runs out when updating it, the index is dropped,
+ *       then 'List_PQPeekMin' and 'List_PQPopMin' scan the list (O(n));
+ *       If the list already has a priority index, it's reordered by the new comparer (O(n))
+ *
+ * @param list The target list
+ * @param comparer A data comparer, the min data has the highest priority
+ *
+ * @return If false, no memory to create the index
+ */
+bool List_CreatePriorityIndex(List_t *list, ListNodeComparer_t comparer);
+
+/**
+ * @brief Destroy the priority index of a list
+ *
+ * @param list The target list
+ */
+void List_DestroyPriorityIndex(List_t *list);
+
+/**
+ * @brief Insert a data into a priority queue (O(log(n)), same as 'List_Push')
+ *
+ * @note The other insert functions also update the priority index
+ *
+ * @param list The target list
+ * @param data A data pointer for new node
+ *
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
+ */
+ListNode_t *List_PQInsert(List_t *list, void *data);
+
+/**
+ * @brief Get the node with the min data (O(1), O(n) if the index was dropped)
+ *
+ * @param list The target list
+ *
+ * @return ListNode_t* The node, if the list is empty (or 'List_CreatePriorityIndex' is not called), return NULL
+ */
+ListNode_t *List_PQPeekMin(List_t *list);
+
+/**
+ * @brief Remove the node with the min data (O(log(n)), O(n) if the index was dropped)
+ *
+ * @note !!! The node need be freed by 'List_FreeNode' !!!
+ *
+ * @param list The target list
+ *
+ * @return ListNode_t* The removed node, if the list is empty (or 'List_CreatePriorityIndex' is not called), return NULL
+ */
+ListNode_t *List_PQPopMin(List_t *list);
+
+/**
+ * @brief Update the position of a node in the priority index after the key of its data is changed
+ *        (O(log(n)), the key can be decreased or increased)
+ *
+ * @note !!! Must be called after changing the key of a data in the list with priority index !!!
+ *
+ * @param list The target list
+ * @param node The node whose key is changed
+ */
+void List_PQDecreaseKey(List_t *list, ListNode_t *node);
+
+/**
+ * @brief Insert a new node in order (ascending), after the nodes which are less or equal to it
+ *
+ * @note The list is searched from the tail, so inserting in order (the common case) is O(1),
+ *       otherwise it's O(n)
+ *
+ * @param list The target list, must be sorted by the same comparer
+ * @param comparer A data comparer
+ * @param data A data pointer for new node
+ *
+ * @return ListNode_t* The new node, if it's an intrusive list, return NULL (nothing todo)
+ */
+ListNode_t *List_InsertSorted(List_t *list, ListNodeComparer_t comparer, void *data);
+
+/**
+ * @brief Free a node which has been removed from the list
+ *        (by 'List_Pop', 'List_Dequeue', 'List_RemoveNode' ...)
+ *
+ * @note The user data of the node will not be freed
+ *
+ * @param list The list which the node was removed from
+ * @param node The removed node
+ */
+void List_FreeNode(List_t *list, ListNode_t *node);
+
 /**
  * @brief Remove all node and destroy the memory for every node
  *
@@ -425,6 +1102,73 @@ void *List_DeleteNode2(List_t *list, ListNode_t *node, bool free_user_data);
  */
 void List_DeleteMatched(List_t *list, ListNodeMatcher_t matcher, void *params);
 
+/**
+ * @brief Remove all matched nodes in one pass and destroy them (same as 'List_DeleteMatched')
+ *
+ * @note The other nodes are relinked in place in one forward pass, the matched nodes are
+ *       destroyed after the lock released;
+ *       In 'LIST_EPOCH_RECLAIM' mode, the batch destructor is not used, the data are freed by
+ *       the list destructor after the readers left
+ *
+ * @param list The target list
+ * @param matcher A node matcher, will be called for every node
+ * @param params User context data
+ * @param batchDestructor If not NULL, it will be called (usually only once) to free the data of
+ *                        all matched nodes instead of the list destructor
+ *
+ * @return The number of removed nodes
+ */
+uint32_t List_Filter(List_t *list, ListNodeMatcher_t matcher, void *params,
+                     ListBatchDestructor_t batchDestructor);
+
+/**
+ * @brief Move all matched nodes to the end of another list in one pass (keep the order)
+ *
+ * @note The nodes are not copied, so the two lists must be able to exchange nodes (see 'List_Splice')
+ *
+ * @param list The source list
+ * @param matcher A node matcher, will be called for every node
+ * @param params User context data
+ * @param dst The target list
+ *
+ * @return The number of moved nodes (0 if the two lists can't exchange nodes)
+ */
+uint32_t List_Partition(List_t *list, ListNodeMatcher_t matcher, void *params, List_t *dst);
+
+/**
+ * @brief Enter a read-side critical section of a list,
+ *        the nodes seen in the section will not be freed until 'List_EpochExit'
+ *
+ * @note Use it to protect a 'List_Foreach' loop from the concurrent writers;
+ *       In 'LIST_EPOCH_RECLAIM' mode, this function doesn't take any lock,
+ *       otherwise it takes the shared lock of the list
+ *       (!!! so don't modify the list in the section if not in 'LIST_EPOCH_RECLAIM' mode !!!)
+ *       In 'LIST_EPOCH_RECLAIM' mode, it waits if a function is relinking the nodes of the list
+ *
+ * @param list The target list
+ *
+ * @return A ticket which must be passed to 'List_EpochExit'
+ */
+uint32_t List_EpochEnter(List_t *list);
+
+/**
+ * @brief Leave a read-side critical section of a list
+ *
+ * @param list The target list
+ * @param ticket The ticket returned by 'List_EpochEnter'
+ */
+void List_EpochExit(List_t *list, uint32_t ticket);
+
+/**
+ * @brief Free the removed nodes (and data) whose readers have all left
+ *        (only for 'LIST_EPOCH_RECLAIM' mode, otherwise nothing todo)
+ *
+ * @note The deferred nodes are also freed by the later deletions and 'List_DestroyList'
+ *
+ * @param list The target list
+ */
+void List_EpochReclaim(List_t *list);
+
 /**
  * @brief Foreach a list with a visitor callback
  *
@@ -432,14 +1176,88 @@ void List_DeleteMatched(List_t *list, ListNodeMatcher_t matcher, void *params);
  * @param visitor A node visitor, will be called for every node
  * @param params User context data
  * @param isReverse If true, we will traverse the list in reverse order
+ *                  (in 'LIST_EPOCH_RECLAIM' mode, only the forward traverse is lock-free)
  */
 void List_Traverse(List_t *list, ListVisitor_t visitor, void *params, bool isReverse);
 
 /**
- * @brief QuickSort a list (ascending order)
+ * @brief MergeSort a list (ascending order, stable, O(n*log(n)) in worst case)
+ *
+ * @note This function relinks the nodes to sort the list and doesn't need any heap memory,
+ *       the data pointer of every list node will NOT be changed
+ *
+ * @param list The target list
+ * @param comparer A node comparer, used to compare two node
+ */
+void List_MergeSort(List_t *list, ListNodeComparer_t comparer);
+
+/**
+ * @brief Natural MergeSort a list (ascending order, stable, adaptive)
+ *
+ * @note This function detects the existing ascending and descending runs and merges them,
+ *       so a nearly sorted list can be sorted in close to O(n) with few comparisons.
+ *       Like 'List_MergeSort', it relinks the nodes and doesn't need any heap memory;
+ *       For random data, 'List_MergeSort' is a bit faster
+ *
+ * @param list The target list
+ * @param comparer A node comparer, used to compare two node
+ */
+void List_NaturalSort(List_t *list, ListNodeComparer_t comparer);
+
+/**
+ * @brief Sort a list via a contiguous array (ascending order, not stable)
  *
- * @note This function will swap the node data pointer to sort the list, 
+ * @note This function gathers the data pointers into an array, sorts the array by introsort,
+ *       and then writes the data pointers back to the nodes in order,
  *       so after sort done, the data pointer of the list node will be changed !
+ *       It's much faster than 'List_MergeSort' for the large list
+ *
+ * @param list The target list
+ * @param comparer A node comparer, used to compare two node
+ * @param buffer A scratch buffer, if it's NULL or it's too small, we will use 'List_mem_alloc' to alloc one
+ * @param bufferSize The number of the data pointers which the scratch buffer can hold
+ *
+ * @return If false, there is no memory for sort buffer, the list is not changed
+ */
+bool List_SortViaArray(List_t *list, ListNodeComparer_t comparer, void **buffer, uint32_t bufferSize);
+
+/**
+ * @brief RadixSort a list by an unsigned integer key (ascending order, stable, O(n))
+ *
+ * @note The key of every data will be extracted only once, the nodes will be relinked,
+ *       the data pointer of every list node will NOT be changed
+ *
+ * @param list The target list
+ * @param extractor A key extractor, used to get the key of a data
+ * @param keyBits The number of the used low bits of the key (1 ~ 64), e.g. 32 for uint32_t key,
+ *                the higher bits of the key are ignored
+ *
+ * @return If false, there is no memory for sort buffer (or invalid keyBits), the list is not changed
+ */
+bool List_RadixSort(List_t *list, ListKeyExtractor_t extractor, uint32_t keyBits);
+
+#ifdef LIST_PARALLEL_SORT
+
+/**
+ * @brief Sort a list on multiple threads (ascending order, stable)
+ *
+ * @note The list will be split into segments, every segment is sorted on a worker thread
+ *       (started by 'List_ThreadNew'), and then the sorted segments are merged in pairs in parallel.
+ *       Like 'List_MergeSort', it relinks the nodes, the data pointer of every list node will NOT be changed.
+ *       !!! The comparer will be called on multiple threads at the same time !!!
+ *
+ * @param list The target list
+ * @param comparer A node comparer, used to compare two node
+ * @param threads The number of the threads (include current thread, max: 64)
+ */
+void List_ParallelSort(List_t *list, ListNodeComparer_t comparer, uint32_t threads);
+
+#endif
+
+/**
+ * @brief Sort a list (ascending order)
+ *
+ * @note Kept for compatibility, it's equal to 'List_MergeSort' now
  *
  * @param list The target list
  * @param comparer A node comparer, used to compare two node
@@ -0,0 +1,427 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include <stdatomic.h>
+
+#include "MPMC_Queue.h"
+
+#undef NULL
+#define NULL List_nullptr
+
+// the state of a cell, every cell is used only once
+#define _MPMC_EMPTY 0
+#define _MPMC_FULL  1
+#define _MPMC_TAKEN 2 // taken by a consumer, or given up by a consumer which came before the producer
+
+typedef struct {
+    atomic_uint state;
+    void *data;
+} _mpmc_cell;
+
+// a segment of the queue, the producers and the consumers take the cells by 'fetch_add' on the indexes,
+// when all cells are taken, the producers link a new segment
+typedef struct _mpmc_segment {
+    _Atomic(struct _mpmc_segment *) next;
+    struct _mpmc_segment *limbo; // the link in a limbo list after it's drained
+    size_t base;                 // the position of the first cell
+    size_t size;
+    char _pad0[MPMC_CACHE_LINE_SIZE];
+    atomic_size_t enqIdx;
+    char _pad1[MPMC_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+    atomic_size_t deqIdx;
+    char _pad2[MPMC_CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+    _mpmc_cell cells[];
+} _mpmc_segment;
+
+struct MPMCQueue_t {
+    void *mem; // the raw memory pointer (before aligned)
+    char _pad0[MPMC_CACHE_LINE_SIZE];
+    _Atomic(_mpmc_segment *) tail;
+    char _pad1[MPMC_CACHE_LINE_SIZE - sizeof(void *)];
+    _Atomic(_mpmc_segment *) head;
+    char _pad2[MPMC_CACHE_LINE_SIZE - sizeof(void *)];
+
+    // the drained segments are freed when no thread can see them (epoch based reclamation)
+    atomic_uint epoch;
+    atomic_flag reclaiming;
+    _Atomic(_mpmc_segment *) limbo[3]; // the drained segments of the last 3 epochs
+    atomic_uint readers[MPMC_EPOCH_SLOTS];
+};
+
+// a reader slot packs '(epoch << 12) | count', the epoch wraps at a multiple of 3 to keep the limbo index
+#define _MPMC_COUNT_BITS  12
+#define _MPMC_COUNT_MASK  ((1u << _MPMC_COUNT_BITS) - 1)
+#define _MPMC_EPOCH_RANGE (3u << 18)
+
+// the slot of current thread (assigned round robin), 0 means not assigned
+static _Thread_local uint32_t _mpmc_slot = 0;
+static atomic_uint _mpmc_next_slot = 1;
+
+//-------------------------------------------------------
+
+static _mpmc_segment *_mpmc_segment_new(size_t size, size_t base)
+{
+    _mpmc_segment *seg;
+    size_t i;
+
+    seg = (_mpmc_segment *)List_mem_alloc(sizeof(_mpmc_segment) + size * sizeof(_mpmc_cell));
+
+    if (seg == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&seg->next, NULL);
+    seg->limbo = NULL;
+    seg->base  = base;
+    seg->size  = size;
+
+    atomic_init(&seg->enqIdx, 0);
+    atomic_init(&seg->deqIdx, 0);
+
+    for (i = 0; i < size; i++) {
+        atomic_init(&seg->cells[i].state, _MPMC_EMPTY);
+        seg->cells[i].data = NULL;
+    }
+
+    return seg;
+}
+
+static void _mpmc_segment_free_chain(_mpmc_segment *seg)
+{
+    _mpmc_segment *next;
+
+    for (; seg != NULL; seg = next) {
+        next = seg->limbo;
+        List_mem_free(seg);
+    }
+}
+
+// enter a section, the segments seen in the section will not be freed until '_mpmc_exit'
+static uint32_t _mpmc_enter(MPMCQueue_t *queue)
+{
+    uint32_t i, n, v, nv, e, start;
+
+    if (_mpmc_slot == 0) {
+        _mpmc_slot = atomic_fetch_add_explicit(&_mpmc_next_slot, 1, memory_order_relaxed);
+    }
+
+    start = (_mpmc_slot - 1) % MPMC_EPOCH_SLOTS;
+    e     = atomic_load(&queue->epoch);
+
+    for (n = 0;; n++) {
+
+        i = (start + n) % MPMC_EPOCH_SLOTS;
+        v = atomic_load_explicit(&queue->readers[i], memory_order_relaxed);
+
+        // take a free slot or share a slot of current epoch,
+        // if all slots are busy, share any of them (an older epoch is always safe)
+        if ((v & _MPMC_COUNT_MASK) == 0) {
+            nv = (e << _MPMC_COUNT_BITS) | 1;
+        } else if (((v >> _MPMC_COUNT_BITS) == e || n >= MPMC_EPOCH_SLOTS) &&
+                   (v & _MPMC_COUNT_MASK) != _MPMC_COUNT_MASK) {
+            nv = v + 1;
+        } else {
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak(&queue->readers[i], &v, nv)) {
+            return i;
+        }
+    }
+}
+
+static List_Inline void _mpmc_exit(MPMCQueue_t *queue, uint32_t slot)
+{
+    atomic_fetch_sub_explicit(&queue->readers[slot], 1, memory_order_release);
+}
+
+// put a drained segment (it's unlinked from 'head' and 'tail') into the limbo of current epoch,
+// the caller must be in a section, so the epoch can't move 2 steps before the segment is in the limbo
+static void _mpmc_retire(MPMCQueue_t *queue, _mpmc_segment *seg)
+{
+    _Atomic(_mpmc_segment *) *limbo = &queue->limbo[atomic_load(&queue->epoch) % 3];
+
+    seg->limbo = atomic_load_explicit(limbo, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(limbo, &seg->limbo, seg,
+                                                  memory_order_release, memory_order_relaxed))
+        ;
+}
+
+// try to advance the epoch and free the segments drained 2 epochs ago,
+// only one thread does it at a time, the others just skip
+static void _mpmc_reclaim(MPMCQueue_t *queue)
+{
+    uint32_t i, v, e, ne;
+    _mpmc_segment *chain;
+
+    if (atomic_load_explicit(&queue->limbo[0], memory_order_relaxed) == NULL &&
+        atomic_load_explicit(&queue->limbo[1], memory_order_relaxed) == NULL &&
+        atomic_load_explicit(&queue->limbo[2], memory_order_relaxed) == NULL) {
+        return; // nothing to reclaim
+    }
+
+    if (atomic_flag_test_and_set_explicit(&queue->reclaiming, memory_order_acquire)) {
+        return;
+    }
+
+    e = atomic_load(&queue->epoch);
+
+    // all active threads must have entered in current epoch
+    for (i = 0; i < MPMC_EPOCH_SLOTS; i++) {
+        v = atomic_load(&queue->readers[i]);
+        if ((v & _MPMC_COUNT_MASK) != 0 && (v >> _MPMC_COUNT_BITS) != e) break;
+    }
+
+    if (i == MPMC_EPOCH_SLOTS) {
+        ne = (e + 1) % _MPMC_EPOCH_RANGE;
+        atomic_store(&queue->epoch, ne);
+
+        chain = atomic_exchange_explicit(&queue->limbo[(ne + 1) % 3], NULL, memory_order_acquire);
+        _mpmc_segment_free_chain(chain);
+    }
+
+    atomic_flag_clear_explicit(&queue->reclaiming, memory_order_release);
+}
+
+MPMCQueue_t *MPMCQueue_CreateQueue(uint32_t capacity)
+{
+    MPMCQueue_t *queue;
+    _mpmc_segment *seg;
+    uintptr_t addr;
+    void *mem;
+    size_t i, cap = 2;
+
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    mem = List_mem_alloc(sizeof(MPMCQueue_t) + MPMC_CACHE_LINE_SIZE - 1);
+
+    if (mem == NULL) {
+        return NULL;
+    }
+
+    seg = _mpmc_segment_new(cap, 0);
+
+    if (seg == NULL) {
+        List_mem_free(mem);
+        return NULL;
+    }
+
+    // keep the positions in their own cache lines
+    addr  = ((uintptr_t)mem + MPMC_CACHE_LINE_SIZE - 1) & ~((uintptr_t)MPMC_CACHE_LINE_SIZE - 1);
+    queue = (MPMCQueue_t *)addr;
+
+    queue->mem = mem;
+
+    atomic_init(&queue->tail, seg);
+    atomic_init(&queue->head, seg);
+    atomic_init(&queue->epoch, 0);
+    atomic_flag_clear(&queue->reclaiming);
+
+    for (i = 0; i < 3; i++) {
+        atomic_init(&queue->limbo[i], NULL);
+    }
+
+    for (i = 0; i < MPMC_EPOCH_SLOTS; i++) {
+        atomic_init(&queue->readers[i], 0);
+    }
+
+    return queue;
+}
+
+void MPMCQueue_DestroyQueue(MPMCQueue_t *queue)
+{
+    _mpmc_segment *seg, *next;
+    uint32_t i;
+
+    for (seg = atomic_load(&queue->head); seg != NULL; seg = next) {
+        next = atomic_load_explicit(&seg->next, memory_order_relaxed);
+        List_mem_free(seg);
+    }
+
+    for (i = 0; i < 3; i++) {
+        _mpmc_segment_free_chain(atomic_load(&queue->limbo[i]));
+    }
+
+    List_mem_free(queue->mem);
+}
+
+bool MPMCQueue_Enqueue(MPMCQueue_t *queue, void *data)
+{
+    _mpmc_segment *seg, *next, *nSeg = NULL;
+    _mpmc_cell *cell;
+    uint32_t slot, state;
+    bool done = false;
+    size_t idx;
+
+    slot = _mpmc_enter(queue);
+
+    while (!done) {
+
+        seg = atomic_load(&queue->tail);
+        idx = atomic_fetch_add_explicit(&seg->enqIdx, 1, memory_order_relaxed);
+
+        if (idx < seg->size) {
+            cell       = &seg->cells[idx];
+            cell->data = data;
+            state      = _MPMC_EMPTY;
+            // if a consumer has given up the cell, take another one
+            done = atomic_compare_exchange_strong_explicit(&cell->state, &state, _MPMC_FULL,
+                                                           memory_order_release, memory_order_relaxed);
+            continue;
+        }
+
+        // the segment is full, move the tail to the next segment
+        next = atomic_load(&seg->next);
+
+        if (next != NULL) {
+            atomic_compare_exchange_strong(&queue->tail, &seg, next);
+            continue;
+        }
+
+        // link a new segment, the data is put into its first cell
+        if (nSeg == NULL) {
+
+            nSeg = _mpmc_segment_new(seg->size < MPMC_MAX_SEGMENT_SIZE ? seg->size * 2 : seg->size, 0);
+
+            if (nSeg == NULL) {
+                break; // no memory
+            }
+
+            nSeg->cells[0].data = data;
+            atomic_init(&nSeg->cells[0].state, _MPMC_FULL);
+            atomic_init(&nSeg->enqIdx, 1);
+        }
+
+        nSeg->base = seg->base + seg->size;
+
+        if (atomic_compare_exchange_strong(&seg->next, &next, nSeg)) {
+            atomic_compare_exchange_strong(&queue->tail, &seg, nSeg);
+            nSeg = NULL;
+            done = true;
+        }
+    }
+
+    _mpmc_exit(queue, slot);
+
+    // another producer linked its segment first, ours is never published
+    if (nSeg != NULL) {
+        List_mem_free(nSeg);
+    }
+
+    return done;
+}
+
+bool MPMCQueue_Dequeue(MPMCQueue_t *queue, void **data)
+{
+    _mpmc_segment *seg, *next, *cur;
+    bool done = false, retired = false;
+    _mpmc_cell *cell;
+    uint32_t slot;
+    size_t idx;
+
+    slot = _mpmc_enter(queue);
+
+    while (!done) {
+
+        seg = atomic_load(&queue->head);
+
+        // don't take (and waste) the cells when the queue is empty
+        if (atomic_load_explicit(&seg->deqIdx, memory_order_relaxed) >=
+                atomic_load_explicit(&seg->enqIdx, memory_order_relaxed) &&
+            atomic_load(&seg->next) == NULL) {
+            break;
+        }
+
+        idx = atomic_fetch_add_explicit(&seg->deqIdx, 1, memory_order_relaxed);
+
+        if (idx < seg->size) {
+            cell = &seg->cells[idx];
+            // if the producer hasn't filled the cell, give it up, the producer will take another one
+            if (atomic_exchange_explicit(&cell->state, _MPMC_TAKEN, memory_order_acquire) == _MPMC_FULL) {
+                *data = cell->data;
+                done  = true;
+            }
+            continue;
+        }
+
+        // the segment is drained, move the head to the next segment
+        next = atomic_load(&seg->next);
+
+        if (next == NULL) {
+            break; // empty
+        }
+
+        // the tail must not stay on a retired segment
+        cur = seg;
+        atomic_compare_exchange_strong(&queue->tail, &cur, next);
+
+        cur = seg;
+        if (atomic_compare_exchange_strong(&queue->head, &cur, next)) {
+            _mpmc_retire(queue, seg);
+            retired = true;
+        }
+    }
+
+    _mpmc_exit(queue, slot);
+
+    if (retired) {
+        _mpmc_reclaim(queue);
+    }
+
+    return done;
+}
+
+uint32_t MPMCQueue_Length(MPMCQueue_t *queue)
+{
+    _mpmc_segment *seg;
+    size_t deqPos, enqPos, deqIdx, enqIdx, idx;
+    uint32_t slot;
+
+    slot = _mpmc_enter(queue);
+    {
+        // the given up cells are passed by both positions, so they are not counted
+        seg    = atomic_load(&queue->head);
+        deqIdx = atomic_load(&seg->deqIdx);
+        enqIdx = atomic_load(&seg->enqIdx);
+        idx    = deqIdx < enqIdx ? deqIdx : enqIdx;
+        deqPos = seg->base + (idx < seg->size ? idx : seg->size);
+
+        seg    = atomic_load(&queue->tail);
+        enqIdx = atomic_load(&seg->enqIdx);
+        enqPos = seg->base + (enqIdx < seg->size ? enqIdx : seg->size);
+    }
+    _mpmc_exit(queue, slot);
+
+    // 'deqPos' is read first and never passes 'enqPos', so the distance is right even after wrap around
+    return (uint32_t)(enqPos - deqPos);
+}
+
+bool MPMCQueue_IsEmpty(MPMCQueue_t *queue)
+{
+    return MPMCQueue_Length(queue) == 0;
+}
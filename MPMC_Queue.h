@@ -0,0 +1,129 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#ifndef _H_C_MPMC_Queue
+#define _H_C_MPMC_Queue
+
+#include "Linked_List.h"
+
+//
+// queue config
+//
+
+#ifndef MPMC_CACHE_LINE_SIZE
+#define MPMC_CACHE_LINE_SIZE 64
+#endif
+
+/**
+ * The max size of a new segment when the queue is full
+ * (every new segment is 2 times the size of the previous one, until this limit)
+ */
+#ifndef MPMC_MAX_SEGMENT_SIZE
+#define MPMC_MAX_SEGMENT_SIZE 65536
+#endif
+
+/**
+ * The number of the reader slots which protect the segments from being freed,
+ * every thread has its own slot (round robin), the threads more than this will share the slots
+ */
+#ifndef MPMC_EPOCH_SLOTS
+#define MPMC_EPOCH_SLOTS 64
+#endif
+
+//
+// queue define
+//
+
+typedef struct MPMCQueue_t MPMCQueue_t;
+
+//
+// functions
+//
+
+/**
+ * @brief Create a lock-free multi-producer/multi-consumer queue
+ *
+ * @note This queue is a chain of array segments built with C11 atomics, the producers and consumers
+ *       take the cells by 'fetch_add' and never take a lock. Like 'List_Enqueue', the enqueue never fails
+ *       for a full queue, a new larger segment is linked when the last one is full;
+ *       the drained segments are freed when no thread can see them (epoch based reclamation)
+ *
+ * @param capacity The size of the first segment (will be rounded up to power of 2)
+ *
+ * @return MPMCQueue_t* A queue, if there is no memory, return NULL
+ */
+MPMCQueue_t *MPMCQueue_CreateQueue(uint32_t capacity);
+
+/**
+ * @brief Destroy queue
+ *
+ * @note !!! The data in queue will not be freed !!!
+ *
+ * @param queue The queue pointer that will be freed
+ */
+void MPMCQueue_DestroyQueue(MPMCQueue_t *queue);
+
+/**
+ * @brief Enqueue a data at end of a queue (thread safe, lock-free)
+ *
+ * @param queue The target queue
+ * @param data A data pointer
+ *
+ * @return If false, there is no memory for a new segment, the data is not enqueued
+ */
+bool MPMCQueue_Enqueue(MPMCQueue_t *queue, void *data);
+
+/**
+ * @brief Dequeue the first data of a queue (thread safe, lock-free)
+ *
+ * @param queue The target queue
+ * @param data Output the data pointer
+ *
+ * @return If false, the queue is empty
+ */
+bool MPMCQueue_Dequeue(MPMCQueue_t *queue, void **data);
+
+/**
+ * @brief Get the number of the data in queue
+ *
+ * @note It's only a snapshot when there are other threads using the queue
+ *
+ * @param queue The target queue
+ *
+ * @return uint32_t
+ */
+uint32_t MPMCQueue_Length(MPMCQueue_t *queue);
+
+/**
+ * @brief Check whether the queue is empty (a snapshot, same as 'MPMCQueue_Length')
+ *
+ * @param queue The target queue
+ *
+ * @return true The queue is empty
+ * @return false The queue is not empty
+ */
+bool MPMCQueue_IsEmpty(MPMCQueue_t *queue);
+
+#endif
@@ -0,0 +1,249 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include <stdatomic.h>
+
+#include "SPSC_Queue.h"
+
+#undef NULL
+#define NULL List_nullptr
+
+// a ring buffer, the data at position 'pos' (pos >= base) is in 'slots[(pos - base) & mask]'
+typedef struct _spsc_segment {
+    _Atomic(struct _spsc_segment *) next; // set by the producer when it moves to a new segment
+    size_t base;                          // the first position in this segment
+    size_t mask;
+    void *slots[];
+} _spsc_segment;
+
+struct SPSCQueue_t {
+    void *mem; // the raw memory pointer (before aligned)
+    bool growable;
+    char _pad0[SPSC_CACHE_LINE_SIZE];
+
+    // producer side
+    atomic_size_t tail;
+    size_t headCache; // a copy of 'head', re-read when the ring looks full
+    _spsc_segment *tailSeg;
+    char _pad1[SPSC_CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t) - sizeof(void *)];
+
+    // consumer side
+    atomic_size_t head;
+    size_t tailCache; // a copy of 'tail', re-read when the ring looks empty
+    _spsc_segment *headSeg;
+    char _pad2[SPSC_CACHE_LINE_SIZE - sizeof(atomic_size_t) - sizeof(size_t) - sizeof(void *)];
+};
+
+//-------------------------------------------------------
+
+static _spsc_segment *_spsc_segment_new(size_t size, size_t base)
+{
+    _spsc_segment *seg;
+
+    seg = (_spsc_segment *)List_mem_alloc(sizeof(_spsc_segment) + size * sizeof(void *));
+
+    if (seg == NULL) {
+        return NULL;
+    }
+
+    atomic_init(&seg->next, NULL);
+    seg->base = base;
+    seg->mask = size - 1;
+
+    return seg;
+}
+
+SPSCQueue_t *SPSCQueue_CreateQueue(uint32_t capacity, bool growable)
+{
+    SPSCQueue_t *queue;
+    _spsc_segment *seg;
+    uintptr_t addr;
+    void *mem;
+    size_t cap = 2;
+
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    mem = List_mem_alloc(sizeof(SPSCQueue_t) + SPSC_CACHE_LINE_SIZE - 1);
+
+    if (mem == NULL) {
+        return NULL;
+    }
+
+    seg = _spsc_segment_new(cap, 0);
+
+    if (seg == NULL) {
+        List_mem_free(mem);
+        return NULL;
+    }
+
+    // keep the positions in their own cache lines
+    addr  = ((uintptr_t)mem + SPSC_CACHE_LINE_SIZE - 1) & ~((uintptr_t)SPSC_CACHE_LINE_SIZE - 1);
+    queue = (SPSCQueue_t *)addr;
+
+    queue->mem      = mem;
+    queue->growable = growable;
+
+    atomic_init(&queue->tail, 0);
+    queue->headCache = 0;
+    queue->tailSeg   = seg;
+
+    atomic_init(&queue->head, 0);
+    queue->tailCache = 0;
+    queue->headSeg   = seg;
+
+    return queue;
+}
+
+void SPSCQueue_DestroyQueue(SPSCQueue_t *queue)
+{
+    _spsc_segment *seg, *next;
+
+    for (seg = queue->headSeg; seg != NULL; seg = next) {
+        next = atomic_load_explicit(&seg->next, memory_order_relaxed);
+        List_mem_free(seg);
+    }
+
+    List_mem_free(queue->mem);
+}
+
+// the used slots of a segment, the consumer may be still in an older segment ('head' is before 'base'),
+// compare the distances back from 'tail', so it still works after the positions wrap around
+static List_Inline size_t _spsc_used(size_t head, size_t base, size_t tail)
+{
+    return (size_t)(tail - head) < (size_t)(tail - base) ? tail - head : tail - base;
+}
+
+bool SPSCQueue_Enqueue(SPSCQueue_t *queue, void *data)
+{
+    _spsc_segment *seg = queue->tailSeg, *nSeg;
+    size_t tail, used, size;
+
+    tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size = seg->mask + 1;
+
+    used = _spsc_used(queue->headCache, seg->base, tail);
+
+    if (used >= size) {
+
+        queue->headCache = atomic_load_explicit(&queue->head, memory_order_acquire);
+        used             = _spsc_used(queue->headCache, seg->base, tail);
+
+        if (used >= size) {
+
+            if (!queue->growable) {
+                return false; // full
+            }
+
+            nSeg = _spsc_segment_new(size < SPSC_MAX_SEGMENT_SIZE ? size * 2 : size, tail);
+
+            if (nSeg == NULL) {
+                return false;
+            }
+
+            // the consumer may see the link before the new 'tail', so publish the segment with it
+            atomic_store_explicit(&seg->next, nSeg, memory_order_release);
+            queue->tailSeg = seg = nSeg;
+        }
+    }
+
+    seg->slots[(tail - seg->base) & seg->mask] = data;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+// return the segment which contains 'head', or NULL if the queue is empty
+static List_Inline _spsc_segment *_spsc_head_segment(SPSCQueue_t *queue, size_t head)
+{
+    _spsc_segment *seg, *next;
+
+    if (head == queue->tailCache) {
+        queue->tailCache = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head == queue->tailCache) return NULL; // empty
+    }
+
+    seg = queue->headSeg;
+
+    // the producer has moved to a newer segment, this one is drained
+    for (next = atomic_load_explicit(&seg->next, memory_order_acquire);
+         next != NULL && next->base == head;
+         next = atomic_load_explicit(&seg->next, memory_order_acquire)) {
+        List_mem_free(seg);
+        queue->headSeg = seg = next;
+    }
+
+    return seg;
+}
+
+bool SPSCQueue_Dequeue(SPSCQueue_t *queue, void **data)
+{
+    _spsc_segment *seg;
+    size_t head;
+
+    head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    seg  = _spsc_head_segment(queue, head);
+
+    if (seg == NULL) {
+        return false;
+    }
+
+    *data = seg->slots[(head - seg->base) & seg->mask];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool SPSCQueue_Peek(SPSCQueue_t *queue, void **data)
+{
+    _spsc_segment *seg;
+    size_t head;
+
+    head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    seg  = _spsc_head_segment(queue, head);
+
+    if (seg == NULL) {
+        return false;
+    }
+
+    *data = seg->slots[(head - seg->base) & seg->mask];
+
+    return true;
+}
+
+uint32_t SPSCQueue_Length(SPSCQueue_t *queue)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    // 'head' is read first and never passes 'tail', so the distance is right even after wrap around
+    return (uint32_t)(tail - head);
+}
+
+bool SPSCQueue_IsEmpty(SPSCQueue_t *queue)
+{
+    return SPSCQueue_Length(queue) == 0;
+}
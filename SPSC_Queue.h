@@ -0,0 +1,132 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#ifndef _H_C_SPSC_Queue
+#define _H_C_SPSC_Queue
+
+#include "Linked_List.h"
+
+//
+// queue config
+//
+
+#ifndef SPSC_CACHE_LINE_SIZE
+#define SPSC_CACHE_LINE_SIZE 64
+#endif
+
+/**
+ * The max size of a new segment when a growable queue is full
+ * (every new segment is 2 times the size of the previous one, until this limit)
+ */
+#ifndef SPSC_MAX_SEGMENT_SIZE
+#define SPSC_MAX_SEGMENT_SIZE 65536
+#endif
+
+//
+// queue define
+//
+
+typedef struct SPSCQueue_t SPSCQueue_t;
+
+//
+// functions
+//
+
+/**
+ * @brief Create a wait-free single-producer/single-consumer queue
+ *
+ * @note This queue is a ring buffer built with C11 atomics, the producer and the consumer
+ *       have their positions in their own cache lines, there is no lock and no allocation per data.
+ *       !!! Only one thread can enqueue and only one thread can dequeue at the same time !!!
+ *
+ * @param capacity The size of ring buffer (will be rounded up to power of 2)
+ * @param growable If true, when the ring is full, a new bigger ring (segment) is chained after it,
+ *                 and the old one is freed by the consumer after it is drained
+ *
+ * @return SPSCQueue_t* A queue, if there is no memory, return NULL
+ */
+SPSCQueue_t *SPSCQueue_CreateQueue(uint32_t capacity, bool growable);
+
+/**
+ * @brief Destroy queue
+ *
+ * @note !!! The data in queue will not be freed !!!
+ *
+ * @param queue The queue pointer that will be freed
+ */
+void SPSCQueue_DestroyQueue(SPSCQueue_t *queue);
+
+/**
+ * @brief Enqueue a data at end of a queue (only for the producer thread, wait-free)
+ *
+ * @param queue The target queue
+ * @param data A data pointer
+ *
+ * @return If false, the queue is full (or there is no memory to grow)
+ */
+bool SPSCQueue_Enqueue(SPSCQueue_t *queue, void *data);
+
+/**
+ * @brief Dequeue the first data of a queue (only for the consumer thread, wait-free)
+ *
+ * @param queue The target queue
+ * @param data Output the data pointer
+ *
+ * @return If false, the queue is empty
+ */
+bool SPSCQueue_Dequeue(SPSCQueue_t *queue, void **data);
+
+/**
+ * @brief Get the first data of a queue without removing it (only for the consumer thread, wait-free)
+ *
+ * @param queue The target queue
+ * @param data Output the data pointer
+ *
+ * @return If false, the queue is empty
+ */
+bool SPSCQueue_Peek(SPSCQueue_t *queue, void **data);
+
+/**
+ * @brief Get the number of the data in queue
+ *
+ * @note It's only a snapshot when there are other threads using the queue
+ *
+ * @param queue The target queue
+ *
+ * @return uint32_t
+ */
+uint32_t SPSCQueue_Length(SPSCQueue_t *queue);
+
+/**
+ * @brief Check whether the queue is empty (a snapshot, same as 'SPSCQueue_Length')
+ *
+ * @param queue The target queue
+ *
+ * @return true The queue is empty
+ * @return false The queue is not empty
+ */
+bool SPSCQueue_IsEmpty(SPSCQueue_t *queue);
+
+#endif
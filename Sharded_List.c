@@ -0,0 +1,209 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include <stdatomic.h>
+
+#include "Sharded_List.h"
+
+#undef NULL
+#define NULL List_nullptr
+
+struct ShardedList_t {
+    List_t **shards;
+    uint32_t count;
+};
+
+// the slot of current thread (assigned round robin), 0 means not assigned, the shard is '(slot - 1) % count'
+static _Thread_local uint32_t _shard_slot = 0;
+static atomic_uint _shard_next_slot = 1;
+
+//-------------------------------------------------------
+
+static List_Inline uint32_t _shard_of_thread(ShardedList_t *list)
+{
+    if (_shard_slot == 0) {
+        _shard_slot = atomic_fetch_add_explicit(&_shard_next_slot, 1, memory_order_relaxed);
+    }
+
+    return (_shard_slot - 1) % list->count;
+}
+
+ShardedList_t *ShardedList_CreateList(uint32_t shards, ListDataDestructor_t destructor)
+{
+    ShardedList_t *list;
+    uint32_t i;
+
+    if (shards == 0) {
+        shards = SHARDED_LIST_DEFAULT_SHARDS;
+    }
+
+    list = (ShardedList_t *)List_mem_alloc(sizeof(ShardedList_t));
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    list->count  = shards;
+    list->shards = (List_t **)List_mem_alloc(shards * sizeof(List_t *));
+
+    if (list->shards == NULL) {
+        List_mem_free(list);
+        return NULL;
+    }
+
+    for (i = 0; i < shards; i++) {
+
+        list->shards[i] = List_CreateList(destructor);
+
+        if (list->shards[i] == NULL) {
+            while (i-- > 0) List_DestroyList(list->shards[i]);
+            List_mem_free(list->shards);
+            List_mem_free(list);
+            return NULL;
+        }
+    }
+
+    return list;
+}
+
+void ShardedList_DestroyList(ShardedList_t *list)
+{
+    uint32_t i;
+
+    for (i = 0; i < list->count; i++) {
+        List_DestroyList(list->shards[i]);
+    }
+
+    List_mem_free(list->shards);
+    List_mem_free(list);
+}
+
+ListNode_t *ShardedList_Push(ShardedList_t *list, void *data)
+{
+    return List_Push(list->shards[_shard_of_thread(list)], data);
+}
+
+bool ShardedList_Dequeue(ShardedList_t *list, void **data)
+{
+    ListNode_t *node;
+    List_t *shard;
+    uint32_t i, own;
+
+    own = _shard_of_thread(list);
+
+    // start from own shard, then steal from the next shards,
+    // the empty shards are skipped by a lock-free length check
+    for (i = 0; i < list->count; i++) {
+
+        shard = list->shards[(own + i) % list->count];
+
+        if (List_IsEmpty(shard)) {
+            continue;
+        }
+
+        node = List_Dequeue(shard);
+
+        if (node != NULL) {
+            *data = node->data;
+            List_FreeNode(shard, node);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t ShardedList_Length(ShardedList_t *list)
+{
+    uint32_t i, len = 0;
+
+    for (i = 0; i < list->count; i++) {
+        len += List_Length(list->shards[i]);
+    }
+
+    return len;
+}
+
+bool ShardedList_IsEmpty(ShardedList_t *list)
+{
+    uint32_t i;
+
+    for (i = 0; i < list->count; i++) {
+        if (!List_IsEmpty(list->shards[i])) return false;
+    }
+
+    return true;
+}
+
+typedef struct {
+    ListVisitor_t visitor;
+    void *params;
+    bool stopped;
+} _shard_visit_ctx;
+
+static bool _shard_visitor(void *dat, void *params)
+{
+    _shard_visit_ctx *ctx = (_shard_visit_ctx *)params;
+
+    if (!ctx->visitor(dat, ctx->params)) {
+        ctx->stopped = true;
+        return false;
+    }
+
+    return true;
+}
+
+void ShardedList_Traverse(ShardedList_t *list, ListVisitor_t visitor, void *params)
+{
+    _shard_visit_ctx ctx;
+    uint32_t i;
+
+    ctx.visitor = visitor;
+    ctx.params  = params;
+    ctx.stopped = false;
+
+    for (i = 0; i < list->count && !ctx.stopped; i++) {
+        List_Traverse(list->shards[i], _shard_visitor, &ctx, false);
+    }
+}
+
+void ShardedList_Clear(ShardedList_t *list)
+{
+    uint32_t i;
+
+    for (i = 0; i < list->count; i++) {
+        List_Clear(list->shards[i]);
+    }
+}
+
+uint32_t ShardedList_ShardCount(ShardedList_t *list)
+{
+    return list->count;
+}
+
+List_t *ShardedList_GetShard(ShardedList_t *list, uint32_t index)
+{
+    return list->shards[index];
+}
@@ -0,0 +1,152 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#ifndef _H_C_Sharded_List
+#define _H_C_Sharded_List
+
+#include "Linked_List.h"
+
+//
+// sharded list config
+//
+
+/**
+ * The number of shards when 'ShardedList_CreateList' get 0,
+ * a good value is the number of cores which push into the list
+ */
+#ifndef SHARDED_LIST_DEFAULT_SHARDS
+#define SHARDED_LIST_DEFAULT_SHARDS 16
+#endif
+
+//
+// sharded list define
+//
+
+typedef struct ShardedList_t ShardedList_t;
+
+//
+// functions
+//
+
+/**
+ * @brief Create a sharded list, it is made of some internal lists (shards), every shard has its own lock
+ *
+ * @note Every thread pushes into its own shard (selected by a thread-local slot, round robin),
+ *       so the producers don't contend for one lock. The order is FIFO in a shard, but not across shards
+ *
+ * @param shards The number of shards, 0 means 'SHARDED_LIST_DEFAULT_SHARDS'
+ * @param destructor A data destructor for every shard, can be NULL
+ *
+ * @return ShardedList_t* A list, if there is no memory, return NULL
+ */
+ShardedList_t *ShardedList_CreateList(uint32_t shards, ListDataDestructor_t destructor);
+
+/**
+ * @brief Destroy a list and all of the nodes in it (the destructor will be called for every data)
+ *
+ * @param list The list pointer that will be freed
+ */
+void ShardedList_DestroyList(ShardedList_t *list);
+
+/**
+ * @brief Push a data at end of the shard of current thread
+ *
+ * @param list The target list
+ * @param data A data pointer
+ *
+ * @return ListNode_t* The new node (same as 'List_Push')
+ */
+ListNode_t *ShardedList_Push(ShardedList_t *list, void *data);
+
+/**
+ * @brief Remove the first data of the shard of current thread,
+ *        if the shard is empty, steal a data from the other shards
+ *
+ * @param list The target list
+ * @param data Output the data pointer (the node is freed, the destructor is not called)
+ *
+ * @return If false, all of the shards are empty
+ */
+bool ShardedList_Dequeue(ShardedList_t *list, void **data);
+
+/**
+ * @brief Get the number of the data in all shards
+ *
+ * @note It's only a snapshot when there are other threads using the list
+ *
+ * @param list The target list
+ *
+ * @return uint32_t
+ */
+uint32_t ShardedList_Length(ShardedList_t *list);
+
+/**
+ * @brief Check whether all shards are empty (a snapshot, same as 'ShardedList_Length')
+ *
+ * @param list The target list
+ *
+ * @return true The list is empty
+ * @return false The list is not empty
+ */
+bool ShardedList_IsEmpty(ShardedList_t *list);
+
+/**
+ * @brief Foreach all shards with a visitor callback (shard by shard, every shard in FIFO order)
+ *
+ * @param list The target list
+ * @param visitor A node visitor, will be called for every node, return false to end early
+ * @param params User context data
+ */
+void ShardedList_Traverse(ShardedList_t *list, ListVisitor_t visitor, void *params);
+
+/**
+ * @brief Remove all data in all shards and destroy the memory for every data
+ *
+ * @param list The target list
+ */
+void ShardedList_Clear(ShardedList_t *list);
+
+/**
+ * @brief Get the number of shards
+ *
+ * @param list The target list
+ *
+ * @return uint32_t
+ */
+uint32_t ShardedList_ShardCount(ShardedList_t *list);
+
+/**
+ * @brief Get a shard, then we can use 'List_xxx' functions on it
+ *
+ * @note !!! Don't destroy the shard !!!
+ *
+ * @param list The target list
+ * @param index The index of shard, must be less than 'ShardedList_ShardCount'
+ *
+ * @return List_t*
+ */
+List_t *ShardedList_GetShard(ShardedList_t *list, uint32_t index);
+
+#endif
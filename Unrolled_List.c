@@ -0,0 +1,568 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include <string.h>
+
+#include "Unrolled_List.h"
+
+#undef NULL
+#define NULL List_nullptr
+
+#if defined(LIST_THREAD_SAFED) && defined(LIST_RWLOCK)
+#define UList_LockNew()          List_RwLockNew()
+#define UList_LockFree(lock)     List_RwLockFree(lock)
+#define UList_Lock(list)         List_RwLockAcquireExclusive(list->lock)
+#define UList_UnLock(list)       List_RwLockReleaseExclusive(list->lock)
+#define UList_LockShared(list)   List_RwLockAcquireShared(list->lock)
+#define UList_UnLockShared(list) List_RwLockReleaseShared(list->lock)
+#elif defined(LIST_THREAD_SAFED)
+#define UList_LockNew()          List_MutexNew()
+#define UList_LockFree(lock)     List_MutexFree(lock)
+#define UList_Lock(list)         List_MutexAcquire(list->lock)
+#define UList_UnLock(list)       List_MutexRelease(list->lock)
+#define UList_LockShared(list)   List_MutexAcquire(list->lock)
+#define UList_UnLockShared(list) List_MutexRelease(list->lock)
+#else
+#define UList_Lock(list)
+#define UList_UnLock(list)
+#define UList_LockShared(list)
+#define UList_UnLockShared(list)
+#endif
+
+// the length of a sorted run before merging
+#define _SORT_RUN_SIZE 16
+
+typedef struct _UListBlock {
+    struct _UListBlock *prev;
+    struct _UListBlock *next;
+    void *mem; // the raw memory pointer (before aligned)
+    uint16_t begin;
+    uint16_t end;
+    void *data[ULIST_BLOCK_SIZE];
+} _UListBlock;
+
+struct UList_t {
+    _UListBlock *head;
+    _UListBlock *tail;
+    uint32_t length;
+    ListDataDestructor_t destructor;
+#ifdef LIST_THREAD_SAFED
+    void *lock;
+#endif
+};
+
+//----------------------------- internal func -----------------------------------
+
+static void _null_data_destructor(void *nul)
+{
+    /* nothing todo */
+}
+
+static _UListBlock *_block_new(void)
+{
+    uintptr_t addr;
+    _UListBlock *block;
+    void *mem = List_mem_alloc(sizeof(_UListBlock) + ULIST_CACHE_LINE_SIZE - 1);
+
+    if (mem == NULL) {
+        return NULL;
+    }
+
+    addr  = ((uintptr_t)mem + ULIST_CACHE_LINE_SIZE - 1) & ~((uintptr_t)ULIST_CACHE_LINE_SIZE - 1);
+    block = (_UListBlock *)addr;
+
+    block->mem   = mem;
+    block->prev  = NULL;
+    block->next  = NULL;
+    block->begin = 0;
+    block->end   = 0;
+
+    return block;
+}
+
+static List_Inline void _block_free(_UListBlock *block)
+{
+    List_mem_free(block->mem);
+}
+
+// unlink and free an empty block
+static void _ulist_drop_block(UList_t *list, _UListBlock *block)
+{
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        list->head = block->next;
+    }
+
+    if (block->next != NULL) {
+        block->next->prev = block->prev;
+    } else {
+        list->tail = block->prev;
+    }
+
+    _block_free(block);
+}
+
+static void _insertion_sort(void **arr, uint32_t n, ListNodeComparer_t comparer)
+{
+    uint32_t i, j;
+    void *dat;
+
+    for (i = 1; i < n; i++) {
+        dat = arr[i];
+        for (j = i; j > 0 && comparer(arr[j - 1], dat) > 0; j--) {
+            arr[j] = arr[j - 1];
+        }
+        arr[j] = dat;
+    }
+}
+
+static void _merge(void **dst, void **left, uint32_t nLeft,
+                   void **right, uint32_t nRight, ListNodeComparer_t comparer)
+{
+    uint32_t l = 0, r = 0;
+
+    while (l < nLeft && r < nRight) {
+        if (comparer(left[l], right[r]) <= 0) {
+            *dst++ = left[l++];
+        } else {
+            *dst++ = right[r++];
+        }
+    }
+
+    while (l < nLeft) *dst++ = left[l++];
+    while (r < nRight) *dst++ = right[r++];
+}
+
+// bottom-up merge sort, 'tmp' must have the same size as 'arr'
+static void _merge_sort(void **arr, void **tmp, uint32_t n, ListNodeComparer_t comparer)
+{
+    void **src = arr, **dst = tmp, **t;
+    uint32_t i, width, mid, end;
+
+    for (i = 0; i < n; i += _SORT_RUN_SIZE) {
+        _insertion_sort(arr + i, (n - i) < _SORT_RUN_SIZE ? (n - i) : _SORT_RUN_SIZE, comparer);
+    }
+
+    for (width = _SORT_RUN_SIZE; width < n; width *= 2) {
+
+        for (i = 0; i < n; i += 2 * width) {
+            mid = (i + width) < n ? (i + width) : n;
+            end = (i + 2 * width) < n ? (i + 2 * width) : n;
+            _merge(dst + i, src + i, mid - i, src + mid, end - mid, comparer);
+        }
+
+        t   = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != arr) {
+        memcpy(arr, src, n * sizeof(void *));
+    }
+}
+
+//-------------------------------------------------------
+
+UList_t *UList_CreateList(ListDataDestructor_t destructor)
+{
+    UList_t *list = (UList_t *)List_mem_alloc(sizeof(UList_t));
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    list->head       = NULL;
+    list->tail       = NULL;
+    list->length     = 0;
+    list->destructor = destructor == NULL ? _null_data_destructor : destructor;
+
+#ifdef LIST_THREAD_SAFED
+    list->lock = UList_LockNew();
+#endif
+
+    return list;
+}
+
+void UList_DestroyList(UList_t *list)
+{
+    UList_Clear(list);
+#ifdef LIST_THREAD_SAFED
+    UList_LockFree(list->lock);
+#endif
+    List_mem_free(list);
+}
+
+void UList_Clear(UList_t *list)
+{
+    _UListBlock *block, *next;
+    uint32_t i;
+
+    UList_Lock(list);
+    {
+        for (block = list->head; block != NULL; block = next) {
+
+            next = block->next;
+
+            if (list->destructor != _null_data_destructor) {
+                for (i = block->begin; i < block->end; i++) {
+                    list->destructor(block->data[i]);
+                }
+            }
+
+            _block_free(block);
+        }
+
+        list->head   = NULL;
+        list->tail   = NULL;
+        list->length = 0;
+    }
+    UList_UnLock(list);
+}
+
+bool UList_Push(UList_t *list, void *data)
+{
+    _UListBlock *block;
+
+    UList_Lock(list);
+    {
+        block = list->tail;
+
+        if (block == NULL || block->end == ULIST_BLOCK_SIZE) {
+
+            block = _block_new();
+
+            if (block == NULL) {
+                UList_UnLock(list);
+                return false;
+            }
+
+            if (list->tail == NULL) {
+                list->head = list->tail = block;
+            } else {
+                list->tail->next = block;
+                block->prev      = list->tail;
+                list->tail       = block;
+            }
+        }
+
+        block->data[block->end++] = data;
+        list->length++;
+    }
+    UList_UnLock(list);
+
+    return true;
+}
+
+bool UList_Prepend(UList_t *list, void *data)
+{
+    _UListBlock *block;
+
+    UList_Lock(list);
+    {
+        block = list->head;
+
+        if (block == NULL || block->begin == 0) {
+
+            block = _block_new();
+
+            if (block == NULL) {
+                UList_UnLock(list);
+                return false;
+            }
+
+            // fill the new block from back to front
+            block->begin = ULIST_BLOCK_SIZE;
+            block->end   = ULIST_BLOCK_SIZE;
+
+            if (list->head == NULL) {
+                list->head = list->tail = block;
+            } else {
+                list->head->prev = block;
+                block->next      = list->head;
+                list->head       = block;
+            }
+        }
+
+        block->data[--block->begin] = data;
+        list->length++;
+    }
+    UList_UnLock(list);
+
+    return true;
+}
+
+bool UList_Pop(UList_t *list, void **data)
+{
+    _UListBlock *block;
+
+    UList_Lock(list);
+    {
+        block = list->tail;
+
+        if (block == NULL) {
+            UList_UnLock(list);
+            return false;
+        }
+
+        *data = block->data[--block->end];
+        list->length--;
+
+        if (block->begin == block->end) {
+            _ulist_drop_block(list, block);
+        }
+    }
+    UList_UnLock(list);
+
+    return true;
+}
+
+bool UList_Enqueue(UList_t *list, void *data)
+{
+    return UList_Push(list, data);
+}
+
+bool UList_Dequeue(UList_t *list, void **data)
+{
+    _UListBlock *block;
+
+    UList_Lock(list);
+    {
+        block = list->head;
+
+        if (block == NULL) {
+            UList_UnLock(list);
+            return false;
+        }
+
+        *data = block->data[block->begin++];
+        list->length--;
+
+        if (block->begin == block->end) {
+            _ulist_drop_block(list, block);
+        }
+    }
+    UList_UnLock(list);
+
+    return true;
+}
+
+uint32_t UList_Length(UList_t *list)
+{
+    uint32_t len;
+    UList_LockShared(list);
+    len = list->length;
+    UList_UnLockShared(list);
+    return len;
+}
+
+bool UList_IsEmpty(UList_t *list)
+{
+    return UList_Length(list) == 0;
+}
+
+void *UList_FindFirst(UList_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    _UListBlock *block;
+    uint32_t i;
+    void *res = NULL;
+
+    UList_LockShared(list);
+    {
+        for (block = list->head; block != NULL; block = block->next) {
+            for (i = block->begin; i < block->end; i++) {
+                if (matcher(block->data[i], params)) {
+                    res = block->data[i];
+                    goto found;
+                }
+            }
+        }
+    found:;
+    }
+    UList_UnLockShared(list);
+
+    return res;
+}
+
+uint32_t UList_Count(UList_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    _UListBlock *block;
+    uint32_t i, count = 0;
+
+    UList_LockShared(list);
+    {
+        for (block = list->head; block != NULL; block = block->next) {
+            for (i = block->begin; i < block->end; i++) {
+                if (matcher(block->data[i], params)) count++;
+            }
+        }
+    }
+    UList_UnLockShared(list);
+
+    return count;
+}
+
+void UList_DeleteMatched(UList_t *list, ListNodeMatcher_t matcher, void *params)
+{
+    _UListBlock *rBlock, *wBlock, *next;
+    uint32_t rIdx, wIdx;
+    void *dat;
+
+    UList_Lock(list);
+    {
+        wBlock = list->head;
+
+        if (wBlock == NULL) {
+            UList_UnLock(list);
+            return;
+        }
+
+        wIdx = wBlock->begin;
+
+        // compact the survivors to the front in one pass,
+        // the write cursor never overtakes the read cursor
+        for (rBlock = list->head; rBlock != NULL; rBlock = rBlock->next) {
+            for (rIdx = rBlock->begin; rIdx < rBlock->end; rIdx++) {
+
+                dat = rBlock->data[rIdx];
+
+                if (matcher(dat, params)) {
+                    list->destructor(dat);
+                    list->length--;
+                    continue;
+                }
+
+                if (wIdx == ULIST_BLOCK_SIZE) {
+                    wBlock->end   = ULIST_BLOCK_SIZE;
+                    wBlock        = wBlock->next;
+                    wBlock->begin = 0;
+                    wIdx          = 0;
+                }
+
+                wBlock->data[wIdx++] = dat;
+            }
+        }
+
+        wBlock->end = wIdx;
+
+        // free the unused blocks
+        for (rBlock = wBlock->next; rBlock != NULL; rBlock = next) {
+            next = rBlock->next;
+            _block_free(rBlock);
+        }
+
+        wBlock->next = NULL;
+        list->tail   = wBlock;
+
+        if (wBlock->begin == wBlock->end) {
+            _ulist_drop_block(list, wBlock);
+        }
+    }
+    UList_UnLock(list);
+}
+
+void UList_Traverse(UList_t *list, ListVisitor_t visitor, void *params, bool isReverse)
+{
+    _UListBlock *block;
+    uint32_t i;
+
+    UList_LockShared(list);
+    {
+        if (isReverse) {
+
+            for (block = list->tail; block != NULL; block = block->prev) {
+                for (i = block->end; i > block->begin; i--) {
+                    if (!visitor(block->data[i - 1], params)) goto end;
+                }
+            }
+
+        } else {
+
+            for (block = list->head; block != NULL; block = block->next) {
+                for (i = block->begin; i < block->end; i++) {
+                    if (!visitor(block->data[i], params)) goto end;
+                }
+            }
+        }
+    end:;
+    }
+    UList_UnLockShared(list);
+}
+
+bool UList_Sort(UList_t *list, ListNodeComparer_t comparer)
+{
+    _UListBlock *block, *next;
+    void **arr;
+    uint32_t i, n, len;
+
+    UList_Lock(list);
+    {
+        len = list->length;
+
+        if (len < 2) {
+            UList_UnLock(list);
+            return true;
+        }
+
+        arr = (void **)List_mem_alloc(2 * len * sizeof(void *));
+
+        if (arr == NULL) {
+            UList_UnLock(list);
+            return false;
+        }
+
+        // gather
+        n = 0;
+        for (block = list->head; block != NULL; block = block->next) {
+            for (i = block->begin; i < block->end; i++) {
+                arr[n++] = block->data[i];
+            }
+        }
+
+        _merge_sort(arr, arr + len, len, comparer);
+
+        // scatter into full blocks
+        n = 0;
+        for (block = list->head; n < len; block = block->next) {
+            block->begin = 0;
+            block->end   = (len - n) < ULIST_BLOCK_SIZE ? (len - n) : ULIST_BLOCK_SIZE;
+            memcpy(block->data, arr + n, block->end * sizeof(void *));
+            n += block->end;
+            list->tail = block;
+        }
+
+        for (block = list->tail->next; block != NULL; block = next) {
+            next = block->next;
+            _block_free(block);
+        }
+
+        list->tail->next = NULL;
+
+        List_mem_free(arr);
+    }
+    UList_UnLock(list);
+
+    return true;
+}
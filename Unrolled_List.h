@@ -0,0 +1,204 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef _H_C_Unrolled_List
+#define _H_C_Unrolled_List
+
+#include "Linked_List.h"
+
+//
+// unrolled list config
+//
+
+/**
+ * The number of data pointers in a block,
+ * default value (28) make a block be 256 bytes (4 cache lines) on 64-bit machine
+ */
+#ifndef ULIST_BLOCK_SIZE
+#define ULIST_BLOCK_SIZE 28
+#endif
+
+#ifndef ULIST_CACHE_LINE_SIZE
+#define ULIST_CACHE_LINE_SIZE 64
+#endif
+
+//
+// unrolled list define
+//
+
+typedef struct UList_t UList_t;
+
+//
+// functions
+//
+
+/**
+ * @brief Create an unrolled list (a list which stores many data pointers in one node)
+ *
+ * @param destructor A data destructor callback function,
+ *                   will be called when use 'UList_DestroyList' to destroy your list;
+ *                   If this params is NULL, we will use default destructor
+ *                   (!!! default destructor will do nothing for your data !!!)
+ *
+ * @return UList_t* A list, if there is no memory, return NULL
+ */
+UList_t *UList_CreateList(ListDataDestructor_t destructor);
+
+/**
+ * @brief Destroy list
+ *
+ * @param list The list pointer that will be freed
+ */
+void UList_DestroyList(UList_t *list);
+
+/**
+ * @brief Remove all data and destroy the memory for every data
+ *
+ * @param list The target list
+ */
+void UList_Clear(UList_t *list);
+
+/**
+ * @brief Push a data at end of a list
+ *
+ * @param list The target list
+ * @param data A data pointer
+ *
+ * @return If false, there is no memory for a new block, the data is not pushed
+ */
+bool UList_Push(UList_t *list, void *data);
+
+/**
+ * @brief Insert a data at front of a list
+ *
+ * @param list The target list
+ * @param data A data pointer
+ *
+ * @return If false, there is no memory for a new block, the data is not pushed
+ */
+bool UList_Prepend(UList_t *list, void *data);
+
+/**
+ * @brief Pop the last data of a list
+ *
+ * @param list The target list
+ * @param data Output the data pointer
+ *
+ * @return If false, the list is empty
+ */
+bool UList_Pop(UList_t *list, void **data);
+
+/**
+ * @brief Enqueue a data at end of a list (Equal to 'UList_Push')
+ *
+ * @param list The target list
+ * @param data A data pointer
+ *
+ * @return If false, there is no memory for a new block, the data is not pushed
+ */
+bool UList_Enqueue(UList_t *list, void *data);
+
+/**
+ * @brief Dequeue the first data of a list
+ *
+ * @param list The target list
+ * @param data Output the data pointer
+ *
+ * @return If false, the list is empty
+ */
+bool UList_Dequeue(UList_t *list, void **data);
+
+/**
+ * @brief Get list length
+ *
+ * @param list The target list
+ *
+ * @return uint32_t
+ */
+uint32_t UList_Length(UList_t *list);
+
+/**
+ * @brief Check whether the list is empty
+ *
+ * @param list The target list
+ *
+ * @return true The list is empty
+ * @return false The list is not empty
+ */
+bool UList_IsEmpty(UList_t *list);
+
+/**
+ * @brief Find the first matched data in a list
+ *
+ * @param list The target list
+ * @param matcher A data matcher, will be called for every data
+ * @param params User context data
+ *
+ * @return void* The matched data, if not found, return NULL
+ */
+void *UList_FindFirst(UList_t *list, ListNodeMatcher_t matcher, void *params);
+
+/**
+ * @brief Get the number of the matched data
+ *
+ * @param list The target list
+ * @param matcher A data matcher, will be called for every data
+ * @param params User context data
+ *
+ * @return uint32_t The number of the matched data
+ */
+uint32_t UList_Count(UList_t *list, ListNodeMatcher_t matcher, void *params);
+
+/**
+ * @brief Remove all matched data and destroy the memory of them
+ *
+ * @param list The target list
+ * @param matcher A data matcher, will be called for every data
+ * @param params User context data
+ */
+void UList_DeleteMatched(UList_t *list, ListNodeMatcher_t matcher, void *params);
+
+/**
+ * @brief Foreach a list with a visitor callback
+ *
+ * @param list The target list
+ * @param visitor A visitor, will be called for every data
+ * @param params User context data
+ * @param isReverse If true, we will traverse the list in reverse order
+ */
+void UList_Traverse(UList_t *list, ListVisitor_t visitor, void *params, bool isReverse);
+
+/**
+ * @brief Sort a list (ascending order, stable)
+ *
+ * @note The blocks will be compacted after sort done
+ *
+ * @param list The target list
+ * @param comparer A data comparer, used to compare two data
+ *
+ * @return If false, there is no memory for sort buffer, the list is not changed
+ */
+bool UList_Sort(UList_t *list, ListNodeComparer_t comparer);
+
+#endif
@@ -0,0 +1,247 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include <stdatomic.h>
+
+#include "WS_Deque.h"
+
+#undef NULL
+#define NULL List_nullptr
+
+typedef struct _ws_buffer {
+    struct _ws_buffer *prev; // the older buffer, freed when the deque is destroyed
+    int64_t mask;
+    _Atomic(void *) slots[];
+} _ws_buffer;
+
+struct WSDeque_t {
+    void *mem; // the raw memory pointer (before aligned)
+    char _pad0[WSDEQUE_CACHE_LINE_SIZE];
+    atomic_int_least64_t top; // thieves take from here
+    char _pad1[WSDEQUE_CACHE_LINE_SIZE - sizeof(atomic_int_least64_t)];
+    atomic_int_least64_t bottom; // the owner pushes/pops here
+    _Atomic(_ws_buffer *) buffer;
+    char _pad2[WSDEQUE_CACHE_LINE_SIZE - sizeof(atomic_int_least64_t) - sizeof(void *)];
+};
+
+//-------------------------------------------------------
+
+static _ws_buffer *_ws_buffer_new(int64_t size)
+{
+    _ws_buffer *buf;
+    int64_t i;
+
+    buf = (_ws_buffer *)List_mem_alloc(sizeof(_ws_buffer) + (size_t)size * sizeof(_Atomic(void *)));
+
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    buf->prev = NULL;
+    buf->mask = size - 1;
+
+    for (i = 0; i < size; i++) {
+        atomic_init(&buf->slots[i], NULL);
+    }
+
+    return buf;
+}
+
+// copy the data in [top, bottom) to a new buffer with double size
+static _ws_buffer *_ws_grow(WSDeque_t *deque, _ws_buffer *old, int64_t top, int64_t bottom)
+{
+    _ws_buffer *buf;
+    int64_t i;
+
+    buf = _ws_buffer_new((old->mask + 1) * 2);
+
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    for (i = top; i < bottom; i++) {
+        atomic_store_explicit(&buf->slots[i & buf->mask],
+                              atomic_load_explicit(&old->slots[i & old->mask], memory_order_relaxed),
+                              memory_order_relaxed);
+    }
+
+    // the thieves may still read the old buffer, so keep it until destroy
+    buf->prev = old;
+    atomic_store_explicit(&deque->buffer, buf, memory_order_release);
+
+    return buf;
+}
+
+WSDeque_t *WSDeque_CreateDeque(uint32_t capacity)
+{
+    WSDeque_t *deque;
+    _ws_buffer *buf;
+    uintptr_t addr;
+    void *mem;
+    int64_t cap = 2;
+
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    mem = List_mem_alloc(sizeof(WSDeque_t) + WSDEQUE_CACHE_LINE_SIZE - 1);
+
+    if (mem == NULL) {
+        return NULL;
+    }
+
+    buf = _ws_buffer_new(cap);
+
+    if (buf == NULL) {
+        List_mem_free(mem);
+        return NULL;
+    }
+
+    // keep the positions in their own cache lines
+    addr  = ((uintptr_t)mem + WSDEQUE_CACHE_LINE_SIZE - 1) & ~((uintptr_t)WSDEQUE_CACHE_LINE_SIZE - 1);
+    deque = (WSDeque_t *)addr;
+
+    deque->mem = mem;
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->buffer, buf);
+
+    return deque;
+}
+
+void WSDeque_DestroyDeque(WSDeque_t *deque)
+{
+    _ws_buffer *buf, *prev;
+
+    for (buf = atomic_load_explicit(&deque->buffer, memory_order_relaxed); buf != NULL; buf = prev) {
+        prev = buf->prev;
+        List_mem_free(buf);
+    }
+
+    List_mem_free(deque->mem);
+}
+
+bool WSDeque_Push(WSDeque_t *deque, void *data)
+{
+    _ws_buffer *buf;
+    int64_t b, t;
+
+    b   = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    t   = atomic_load_explicit(&deque->top, memory_order_acquire);
+    buf = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+    if (b - t > buf->mask) {
+        buf = _ws_grow(deque, buf, t, b);
+        if (buf == NULL) return false; // full
+    }
+
+    atomic_store_explicit(&buf->slots[b & buf->mask], data, memory_order_relaxed);
+
+    // publish the data before the new bottom
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+
+    return true;
+}
+
+bool WSDeque_Pop(WSDeque_t *deque, void **data)
+{
+    _ws_buffer *buf;
+    int64_t b, t;
+    void *val;
+    bool ok = true;
+
+    b   = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    buf = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+    // reserve the last data, then check whether a thief has taken it
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t <= b) {
+
+        val = atomic_load_explicit(&buf->slots[b & buf->mask], memory_order_relaxed);
+
+        if (t == b) {
+            // it's the last one, race with the thieves
+            ok = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                         memory_order_seq_cst, memory_order_relaxed);
+            atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        }
+
+    } else {
+        // empty
+        ok = false;
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+
+    if (ok) {
+        *data = val;
+    }
+
+    return ok;
+}
+
+bool WSDeque_Steal(WSDeque_t *deque, void **data)
+{
+    _ws_buffer *buf;
+    int64_t b, t;
+    void *val;
+
+    for (;;) {
+
+        t = atomic_load_explicit(&deque->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+        if (t >= b) {
+            return false; // empty
+        }
+
+        buf = atomic_load_explicit(&deque->buffer, memory_order_acquire);
+        val = atomic_load_explicit(&buf->slots[t & buf->mask], memory_order_relaxed);
+
+        // if failed, the data has been taken by the owner or another thief, try again
+        if (atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed)) {
+            *data = val;
+            return true;
+        }
+    }
+}
+
+uint32_t WSDeque_Length(WSDeque_t *deque)
+{
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    return b > t ? (uint32_t)(b - t) : 0;
+}
+
+bool WSDeque_IsEmpty(WSDeque_t *deque)
+{
+    return WSDeque_Length(deque) == 0;
+}
@@ -0,0 +1,122 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#ifndef _H_C_WS_Deque
+#define _H_C_WS_Deque
+
+#include "Linked_List.h"
+
+//
+// deque config
+//
+
+#ifndef WSDEQUE_CACHE_LINE_SIZE
+#define WSDEQUE_CACHE_LINE_SIZE 64
+#endif
+
+//
+// deque define
+//
+
+typedef struct WSDeque_t WSDeque_t;
+
+//
+// functions
+//
+
+/**
+ * @brief Create a work-stealing deque (Chase-Lev), built with C11 atomics
+ *
+ * @note The deque has one owner thread, which pushes and pops at the bottom without lock (LIFO),
+ *       the other threads (thieves) steal from the top by CAS (FIFO).
+ *       The buffer grows when it is full, the old buffers are freed by 'WSDeque_DestroyDeque'
+ *
+ * @param capacity The initial size of buffer (will be rounded up to power of 2)
+ *
+ * @return WSDeque_t* A deque, if there is no memory, return NULL
+ */
+WSDeque_t *WSDeque_CreateDeque(uint32_t capacity);
+
+/**
+ * @brief Destroy deque
+ *
+ * @note !!! The data in deque will not be freed !!!
+ *
+ * @param deque The deque pointer that will be freed
+ */
+void WSDeque_DestroyDeque(WSDeque_t *deque);
+
+/**
+ * @brief Push a data at the bottom of a deque (only for owner thread, lock-free)
+ *
+ * @param deque The target deque
+ * @param data A data pointer
+ *
+ * @return If false, the deque is full and there is no memory to grow
+ */
+bool WSDeque_Push(WSDeque_t *deque, void *data);
+
+/**
+ * @brief Pop the last pushed data at the bottom of a deque (only for owner thread, lock-free)
+ *
+ * @param deque The target deque
+ * @param data Output the data pointer
+ *
+ * @return If false, the deque is empty
+ */
+bool WSDeque_Pop(WSDeque_t *deque, void **data);
+
+/**
+ * @brief Steal the first data at the top of a deque (thread safe, lock-free)
+ *
+ * @param deque The target deque
+ * @param data Output the data pointer
+ *
+ * @return If false, the deque is empty
+ */
+bool WSDeque_Steal(WSDeque_t *deque, void **data);
+
+/**
+ * @brief Get the number of the data in deque
+ *
+ * @note It's only a snapshot when there are other threads using the deque
+ *
+ * @param deque The target deque
+ *
+ * @return uint32_t
+ */
+uint32_t WSDeque_Length(WSDeque_t *deque);
+
+/**
+ * @brief Check whether the deque is empty (a snapshot, same as 'WSDeque_Length')
+ *
+ * @param deque The target deque
+ *
+ * @return true The deque is empty
+ * @return false The deque is not empty
+ */
+bool WSDeque_IsEmpty(WSDeque_t *deque);
+
+#endif
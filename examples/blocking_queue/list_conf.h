@@ -0,0 +1,67 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+#define LIST_THREAD_SAFED
+#define LIST_BLOCKING_QUEUE
+
+static inline void *_list_mutex_new(void)
+{
+    pthread_mutex_t *mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+static inline void _list_mutex_free(void *mutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+static inline void *_list_cond_new(void)
+{
+    pthread_cond_t *cond = (pthread_cond_t *)malloc(sizeof(pthread_cond_t));
+    pthread_cond_init(cond, NULL);
+    return cond;
+}
+
+static inline void _list_cond_free(void *cond)
+{
+    pthread_cond_destroy((pthread_cond_t *)cond);
+    free(cond);
+}
+
+static inline bool _list_cond_wait(void *cond, void *mutex, uint32_t timeout)
+{
+    struct timespec ts;
+
+    if (timeout == 0xFFFFFFFFu) { // LIST_WAIT_FOREVER
+        pthread_cond_wait((pthread_cond_t *)cond, (pthread_mutex_t *)mutex);
+        return true;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (long)(timeout % 1000) * 1000000L;
+
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return pthread_cond_timedwait((pthread_cond_t *)cond, (pthread_mutex_t *)mutex, &ts) != ETIMEDOUT;
+}
+
+#define List_MutexNew()          _list_mutex_new()
+#define List_MutexFree(mutex)    _list_mutex_free(mutex)
+#define List_MutexAcquire(mutex) pthread_mutex_lock((pthread_mutex_t *)(mutex))
+#define List_MutexRelease(mutex) pthread_mutex_unlock((pthread_mutex_t *)(mutex))
+
+#define List_CondNew()                      _list_cond_new()
+#define List_CondFree(cond)                 _list_cond_free(cond)
+#define List_CondWait(cond, mutex, timeout) _list_cond_wait(cond, mutex, timeout)
+#define List_CondSignal(cond)               pthread_cond_signal((pthread_cond_t *)(cond))
+#define List_CondBroadcast(cond)            pthread_cond_broadcast((pthread_cond_t *)(cond))
@@ -0,0 +1,214 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Linked_List.h"
+
+//
+// Blocking queue: the consumers wait in 'List_DequeueWait' for new data,
+// the producers wait in 'List_EnqueueWait' when the list is full,
+// and 'List_Close' wakes up all of them, then the consumers drain the list and quit
+//
+
+#define PRODUCERS      3
+#define CONSUMERS      2
+#define PRODUCER_ITEMS 10000
+#define QUEUE_CAPACITY 8
+
+static atomic_uint consumed;
+static atomic_ulong consumed_sum;
+
+static double elapsed_ms(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1000.0 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static bool visitor_print(void *data, void *params)
+{
+    printf("'%s' -> ", (char *)data);
+    return true;
+}
+
+static void *slow_consumer_main(void *arg)
+{
+    List_t *list = (List_t *)arg;
+    void *data;
+
+    usleep(50 * 1000);
+
+    if (List_DequeueWait(list, &data, LIST_WAIT_FOREVER)) {
+        printf("consumer: dequeue '%s'\n", (char *)data);
+    }
+
+    return NULL;
+}
+
+static void *producer_main(void *arg)
+{
+    List_t *list = (List_t *)arg;
+    uintptr_t i;
+
+    for (i = 1; i <= PRODUCER_ITEMS; i++) {
+        List_EnqueueWait(list, (void *)i, LIST_WAIT_FOREVER);
+    }
+
+    return NULL;
+}
+
+static void *consumer_main(void *arg)
+{
+    List_t *list = (List_t *)arg;
+    void *data;
+
+    // return false only when the list is closed and drained
+    while (List_DequeueWait(list, &data, LIST_WAIT_FOREVER)) {
+        atomic_fetch_add(&consumed, 1);
+        atomic_fetch_add(&consumed_sum, (unsigned long)(uintptr_t)data);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS], consumer;
+    struct timespec start;
+    unsigned long expect_sum;
+    List_t *list;
+    void *data;
+    bool done;
+    double ms;
+    uint32_t i;
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'DequeueWait' (timeout) ======================\n");
+
+    list = List_CreateList(NULL);
+
+    printf("\n============> Dequeue an empty list, don't wait\n");
+    printf("dequeue: %s\n", List_DequeueWait(list, &data, 0) ? "ok" : "empty");
+
+    printf("\n============> Dequeue an empty list, wait 100 ms\n");
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    done = List_DequeueWait(list, &data, 100);
+    ms   = elapsed_ms(&start);
+    printf("dequeue: %s, waited at least 100 ms: %s\n", done ? "ok" : "timeout", ms >= 99.0 ? "yes" : "no");
+
+    List_DestroyList(list);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'SetCapacity' 'EnqueueWait' ======================\n");
+
+    list = List_CreateList(NULL);
+    List_SetCapacity(list, 2);
+
+    printf("\n============> Enqueue 3 nodes (capacity: 2), don't wait\n");
+    {
+        const char *names[] = {"node 1", "node 2", "node 3"};
+        for (i = 0; i < 3; i++) {
+            printf("enqueue '%s': %s\n", names[i], List_EnqueueWait(list, (void *)names[i], 0) ? "ok" : "full");
+        }
+    }
+
+    printf("\n============> Enqueue 'node 3' with 20 ms timeout\n");
+    printf("enqueue 'node 3': %s\n", List_EnqueueWait(list, "node 3", 20) ? "ok" : "timeout");
+
+    printf("\n============> Enqueue 'node 3' and wait, a consumer dequeues a node after 50 ms\n");
+    pthread_create(&consumer, NULL, slow_consumer_main, list);
+    done = List_EnqueueWait(list, "node 3", LIST_WAIT_FOREVER);
+    pthread_join(consumer, NULL);
+    printf("enqueue 'node 3': %s\n", done ? "ok" : "failed");
+    List_Traverse(list, visitor_print, NULL, false);
+    printf("\n");
+
+    List_DestroyList(list);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Close' (drain) ======================\n");
+
+    list = List_CreateList(NULL);
+
+    printf("\n============> Close a list with 2 nodes, then dequeue 3 times\n");
+    List_EnqueueWait(list, "node 1", 0);
+    List_EnqueueWait(list, "node 2", 0);
+    List_Close(list);
+    for (i = 0; i < 3; i++) {
+        if (List_DequeueWait(list, &data, LIST_WAIT_FOREVER)) {
+            printf("dequeue: '%s'\n", (char *)data);
+        } else {
+            printf("dequeue: closed and drained\n");
+        }
+    }
+
+    List_DestroyList(list);
+
+    list = List_CreateList(NULL);
+    List_SetCapacity(list, QUEUE_CAPACITY);
+
+    printf("\n============> %d producers, %d consumers (capacity: %d)\n", PRODUCERS, CONSUMERS, QUEUE_CAPACITY);
+
+    for (i = 0; i < CONSUMERS; i++) {
+        pthread_create(&consumers[i], NULL, consumer_main, list);
+    }
+
+    for (i = 0; i < PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, producer_main, list);
+    }
+
+    for (i = 0; i < PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+
+    // the consumers still drain the nodes in the list after it's closed
+    List_Close(list);
+
+    for (i = 0; i < CONSUMERS; i++) {
+        pthread_join(consumers[i], NULL);
+    }
+
+    expect_sum = (unsigned long)PRODUCERS * PRODUCER_ITEMS * (PRODUCER_ITEMS + 1) / 2;
+
+    printf("consumed: %d (expect: %d), sum: %s\n", atomic_load(&consumed), PRODUCERS * PRODUCER_ITEMS,
+           atomic_load(&consumed_sum) == expect_sum ? "ok" : "wrong");
+
+    printf("\n============> Enqueue/Dequeue a closed list\n");
+    printf("closed: %s\n", List_IsClosed(list) ? "yes" : "no");
+    printf("enqueue: %s\n", List_EnqueueWait(list, "node 1", LIST_WAIT_FOREVER) ? "ok" : "failed");
+    printf("dequeue: %s\n", List_DequeueWait(list, &data, LIST_WAIT_FOREVER) ? "ok" : "failed");
+
+    List_DestroyList(list);
+
+    return 0;
+}
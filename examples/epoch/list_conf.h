@@ -0,0 +1,26 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#define LIST_THREAD_SAFED
+#define LIST_EPOCH_RECLAIM
+
+static inline void *_list_mutex_new(void)
+{
+    pthread_mutex_t *mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+static inline void _list_mutex_free(void *mutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+#define List_MutexNew()          _list_mutex_new()
+#define List_MutexFree(mutex)    _list_mutex_free(mutex)
+#define List_MutexAcquire(mutex) pthread_mutex_lock((pthread_mutex_t *)(mutex))
+#define List_MutexRelease(mutex) pthread_mutex_unlock((pthread_mutex_t *)(mutex))
+
+#define List_EpochPause() sched_yield()
@@ -0,0 +1,193 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "Linked_List.h"
+
+//
+// Epoch based reclamation: the readers traverse the list without any lock,
+// while the writers delete, append and sort the nodes.
+//
+// Every item has a magic number, the destructor clears it before the item is freed,
+// so a reader which sees a freed item (or a node which is not in the list) will find a wrong magic
+//
+
+#define READERS     4
+#define WRITERS     2
+#define WRITER_OPS  20000
+#define ITEM_MAGIC  0x4c495354
+
+typedef struct {
+    uint32_t magic;
+    uint32_t value;
+} item_t;
+
+static List_t *list;
+static atomic_bool stop;
+static atomic_uint created;
+static atomic_uint destroyed;
+static atomic_uint bad_items;
+static atomic_ulong visits;
+
+static item_t *new_item(uint32_t value)
+{
+    item_t *item = (item_t *)malloc(sizeof(item_t));
+    item->magic  = ITEM_MAGIC;
+    item->value  = value;
+    atomic_fetch_add(&created, 1);
+    return item;
+}
+
+static void destructor(void *data)
+{
+    item_t *item = (item_t *)data;
+    if (item->magic != ITEM_MAGIC) atomic_fetch_add(&bad_items, 1);
+    item->magic = 0;
+    free(item);
+    atomic_fetch_add(&destroyed, 1);
+}
+
+static int comparer(void *d1, void *d2)
+{
+    uint32_t v1 = ((item_t *)d1)->value, v2 = ((item_t *)d2)->value;
+    return v1 < v2 ? -1 : (v1 > v2 ? 1 : 0);
+}
+
+static bool value_matcher(void *data, void *params)
+{
+    return ((item_t *)data)->value % 16 == (uint32_t)(uintptr_t)params;
+}
+
+static bool checker(void *data, void *params)
+{
+    if (((item_t *)data)->magic != ITEM_MAGIC) atomic_fetch_add(&bad_items, 1);
+    (*(uint64_t *)params)++;
+    return true;
+}
+
+static void *reader_main(void *arg)
+{
+    uint64_t count = 0;
+    ListNode_t *node;
+    uint32_t ticket;
+
+    while (!atomic_load(&stop)) {
+
+        List_Traverse(list, checker, &count, false);
+
+        // a 'List_Foreach' loop is protected by a read-side section
+        ticket = List_EpochEnter(list);
+        List_Foreach(list, node)
+        {
+            checker(node->data, &count);
+        }
+        List_EpochExit(list, ticket);
+    }
+
+    atomic_fetch_add(&visits, count);
+
+    return NULL;
+}
+
+static void *writer_main(void *arg)
+{
+    uint32_t seed = (uint32_t)(uintptr_t)arg, i, ticket;
+    ListNode_t *node;
+
+    for (i = 0; i < WRITER_OPS; i++) {
+
+        seed = seed * 1103515245 + 12345;
+
+        switch ((seed >> 16) % 8) {
+        case 0:
+        case 1:
+        case 2:
+            List_Push(list, new_item(seed >> 8));
+            break;
+        case 3:
+            List_Prepend(list, new_item(seed >> 8));
+            break;
+        case 4:
+        case 5:
+            // the node found in a section will not be freed until the section is left,
+            // it may be deleted by another writer, 'List_DeleteNode' will skip it
+            ticket = List_EpochEnter(list);
+            node   = List_FindFirst(list, value_matcher, (void *)(uintptr_t)((seed >> 8) % 16));
+            if (node != NULL) List_DeleteNode(list, node);
+            List_EpochExit(list, ticket);
+            break;
+        case 6:
+            List_DeleteMatched(list, value_matcher, (void *)(uintptr_t)((seed >> 8) % 16));
+            break;
+        default:
+            // the sort waits for the readers to leave, the new readers wait for the sort
+            if ((seed >> 24) % 32 == 0) List_MergeSort(list, comparer);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t readers[READERS], writers[WRITERS];
+    uint32_t i;
+
+    printf("\n==================== Test 'EpochEnter' 'Traverse' 'DeleteNode' 'MergeSort' ======================\n\n");
+
+    list = List_CreateList(destructor);
+
+    for (i = 0; i < READERS; i++) {
+        pthread_create(&readers[i], NULL, reader_main, NULL);
+    }
+
+    for (i = 0; i < WRITERS; i++) {
+        pthread_create(&writers[i], NULL, writer_main, (void *)(uintptr_t)(i + 1));
+    }
+
+    for (i = 0; i < WRITERS; i++) {
+        pthread_join(writers[i], NULL);
+    }
+
+    atomic_store(&stop, true);
+
+    for (i = 0; i < READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    printf("readers: %d, writers: %d, visited nodes: %lu, list length: %d\n",
+           READERS, WRITERS, (unsigned long)atomic_load(&visits), List_Length(list));
+
+    List_DestroyList(list);
+
+    printf("created items: %d, destroyed items: %d, bad items: %d\n",
+           atomic_load(&created), atomic_load(&destroyed), atomic_load(&bad_items));
+
+    return atomic_load(&created) == atomic_load(&destroyed) && atomic_load(&bad_items) == 0 ? 0 : 1;
+}
@@ -23,9 +23,14 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "Linked_List.h"
+#include "Unrolled_List.h"
+#include "MPMC_Queue.h"
+#include "Sharded_List.h"
+#include "SPSC_Queue.h"
 
 bool visitor_print(void *data, void *params)
 {
@@ -40,11 +45,44 @@ bool visitor_print_with_arrow(void *data, void *params)
     return true;
 }
 
+bool matcher_contains(void *str, void *sub)
+{
+    return strstr((char *)str, (char *)sub) != NULL;
+}
+
+void batch_free(void **data, size_t n)
+{
+    printf("free %d nodes at once\n", (int)n);
+    for (size_t i = 0; i < n; i++) free(data[i]);
+}
+
 int comparer(void *str1, void *str2)
 {
     return strcmp((char *)str1, (char *)str2);
 }
 
+uint32_t hasher(void *str)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char *c = (const char *)str; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash;
+}
+
+// the number in the name, e.g. 12 for 'node 12'
+uint64_t key_extractor(void *str)
+{
+    const char *num = strrchr((const char *)str, ' ');
+    return num != NULL ? (uint64_t)strtoul(num + 1, NULL, 10) : 0;
+}
+
+typedef struct {
+    int id;
+    ListNode_t link;
+} task_t;
+
 int main()
 {
     List_t *list = List_CreateList(NULL);
@@ -83,7 +121,7 @@ int main()
 
     printf("============> 4 List_Dequeue\n");
     printf("pop '%s'\n", (char *)List_First(list)->data);
-    free(List_Dequeue(list));
+    List_FreeNode(list, List_Dequeue(list));
     List_Traverse(list, visitor_print, NULL, false);
 
     // 5
@@ -105,7 +143,7 @@ int main()
                 List_DeleteNode(list, ele);
             }
 
-            if (strstr((char *)ele->data, "7")) {
+            else if (strstr((char *)ele->data, "7")) {
                 List_DeleteNode(list, ele);
             }
         }
@@ -215,5 +253,439 @@ int main()
     printf("\n============> Destroy (len: %d)\n", List_Length(list));
     List_DestroyList(list);
 
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'NodePool' ======================\n");
+
+    ListNodePool_t *pool = List_CreateNodePool(8);
+    List_t *list_a       = List_CreateListWithPool(NULL, pool);
+    List_t *list_b       = List_CreateListWithPool(NULL, NULL);
+
+    printf("\n============> Push 20 nodes (pool chunk size: 8)\n");
+    for (size_t i = 0; i < 20; i++) {
+        List_Push(list_a, (void *)"pool node");
+        List_Push(list_b, (void *)"private pool node");
+    }
+    printf("list_a len: %d, list_b len: %d\n", List_Length(list_a), List_Length(list_b));
+
+    printf("\n============> Dequeue and free 5 nodes, then Clear\n");
+    for (size_t i = 0; i < 5; i++) {
+        List_FreeNode(list_a, List_Dequeue(list_a));
+    }
+    printf("list_a len: %d\n", List_Length(list_a));
+    List_Clear(list_a);
+    printf("list_a len: %d\n", List_Length(list_a));
+
+    printf("\n============> Destroy lists and pool\n");
+    List_DestroyList(list_a);
+    List_DestroyList(list_b);
+    List_DestroyNodePool(pool);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Batch' ======================\n");
+
+    List_t *list_c = List_CreateListWithPool(NULL, NULL);
+
+    printf("\n============> PushBatch, PrependBatch, InsertBatch after 'node 2'\n");
+    {
+        void *tails[] = {"node 1", "node 2", "node 3"};
+        void *heads[] = {"node -1", "node 0"};
+        void *mids[]  = {"node 2.1", "node 2.2"};
+
+        List_PushBatch(list_c, tails, 3);
+        List_PrependBatch(list_c, heads, 2);
+        List_InsertBatch(list_c, List_Last(list_c)->prev, mids, 2);
+    }
+    List_Traverse(list_c, visitor_print_with_arrow, NULL, false);
+    printf("\nlen: %d\n", List_Length(list_c));
+
+    printf("\n============> DequeueBatch 2 nodes, PopBatch 2 nodes\n");
+    {
+        void *out[2];
+        uint32_t n = List_DequeueBatch(list_c, out, 2);
+        for (uint32_t i = 0; i < n; i++) printf("dequeue '%s'\n", (char *)out[i]);
+        n = List_PopBatch(list_c, out, 2);
+        for (uint32_t i = 0; i < n; i++) printf("pop '%s'\n", (char *)out[i]);
+    }
+
+    printf("\n============> Move all nodes into a new list\n");
+    {
+        List_t *list_d = List_DequeueList(list_c, UINT32_MAX);
+        List_Traverse(list_d, visitor_print_with_arrow, NULL, false);
+        printf("\nlen: %d, source len: %d\n", List_Length(list_d), List_Length(list_c));
+        List_DestroyList(list_d);
+    }
+
+    List_DestroyList(list_c);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Splice' 'Concat' 'SplitAt' ======================\n");
+
+    List_t *list_e = List_CreateList(NULL);
+    List_t *list_f = List_CreateList(NULL);
+
+    {
+        void *nums[] = {"node 1", "node 2", "node 3", "node 4", "node 5", "node 6"};
+        List_PushBatch(list_e, nums, 3);
+        List_PushBatch(list_f, nums + 3, 3);
+    }
+
+    printf("\n============> Concat [4, 5, 6] to [1, 2, 3]\n");
+    List_Concat(list_e, list_f);
+    List_Traverse(list_e, visitor_print_with_arrow, NULL, false);
+    printf("\nlen: %d, source len: %d\n", List_Length(list_e), List_Length(list_f));
+
+    printf("\n============> SplitAt 'node 3'\n");
+    {
+        List_t *list_g = List_SplitAt(list_e, List_First(list_e)->next->next);
+        List_Traverse(list_e, visitor_print_with_arrow, NULL, false);
+        printf("| ");
+        List_Traverse(list_g, visitor_print_with_arrow, NULL, false);
+
+        printf("\n\n============> Splice them back after 'node 1'\n");
+        List_Splice(list_e, List_First(list_e), list_g);
+        List_Traverse(list_e, visitor_print_with_arrow, NULL, false);
+        printf("\n");
+
+        List_DestroyList(list_g);
+    }
+
+    List_DestroyList(list_e);
+    List_DestroyList(list_f);
+
+    printf("\n============> SplitAt a list with private pool, destroy the source list first\n");
+    {
+        List_t *list_h = List_CreateListWithPool(NULL, NULL);
+
+        for (size_t i = 0; i < 6; i++) {
+            List_Push(list_h, (void *)(i % 2 ? "odd" : "even"));
+        }
+
+        List_t *list_i = List_SplitAt(list_h, List_First(list_h)->next->next);
+        List_t *list_j = List_DequeueList(list_h, 1);
+
+        // the private pool is shared, it's released by the last list
+        List_DestroyList(list_h);
+        List_Traverse(list_i, visitor_print_with_arrow, NULL, false);
+        List_Traverse(list_j, visitor_print_with_arrow, NULL, false);
+        printf("\n");
+
+        List_DestroyList(list_j);
+        List_DestroyList(list_i);
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Index' 'FindByKey' 'DeleteByKey' ======================\n");
+
+    List_t *list_k = List_CreateList(NULL);
+
+    {
+        void *names[] = {"node 5", "node 2", "node 4", "node 1", "node 3"};
+        List_PushBatch(list_k, names, 5);
+    }
+
+    List_CreateIndex(list_k, hasher, comparer);
+
+    printf("\n============> FindByKey 'node 4': %s, 'node 9': %s\n",
+           List_FindByKey(list_k, "node 4") != NULL ? "found" : "not found",
+           List_FindByKey(list_k, "node 9") != NULL ? "found" : "not found");
+
+    printf("\n============> DeleteByKey 'node 2'\n");
+    List_DeleteByKey(list_k, "node 2");
+    List_Traverse(list_k, visitor_print_with_arrow, NULL, false);
+    printf("\nFindByKey 'node 2': %s\n", List_FindByKey(list_k, "node 2") != NULL ? "found" : "not found");
+
+    // 'SortViaArray' moves the data between nodes, so the index is rebuilt
+    printf("\n============> SortViaArray, then FindByKey 'node 1' is the first node: %s\n",
+           List_SortViaArray(list_k, comparer, NULL, 0) &&
+                   List_FindByKey(list_k, "node 1") == List_First(list_k)
+               ? "yes"
+               : "no");
+
+    List_DestroyIndex(list_k);
+    List_DestroyList(list_k);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'At' 'IndexOf' 'InsertAt' ======================\n");
+
+    List_t *list_p = List_CreateList(NULL);
+
+    List_CreatePositionIndex(list_p);
+
+    for (size_t i = 0; i < 10; i++) {
+        List_Push(list_p, (void *)"node");
+    }
+
+    printf("\n============> InsertAt 0, 5, 100\n");
+    List_InsertAt(list_p, 0, (void *)"node at 0");
+    List_InsertAt(list_p, 5, (void *)"node at 5");
+    List_InsertAt(list_p, 100, (void *)"node at end");
+    List_Traverse(list_p, visitor_print_with_arrow, NULL, false);
+
+    printf("\n\n============> At 5: '%s', IndexOf last node: %d\n",
+           List_GetNodeData(List_At(list_p, 5), char), List_IndexOf(list_p, List_Last(list_p)));
+
+    List_DestroyList(list_p);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Filter' 'Partition' ======================\n");
+
+    List_t *list_h = List_CreateList(free);
+    List_t *list_i = List_CreateList(free);
+
+    for (size_t i = 0; i < 20; i++) {
+        char *str = malloc(64);
+        sprintf(str, "node %d", (int)(i + 1));
+        List_Push(list_h, str);
+    }
+
+    printf("\n============> Count nodes which contains '1', '2', '3'\n");
+    {
+        ListNodeMatcher_t matchers[] = {matcher_contains, matcher_contains, matcher_contains};
+        void *subs[]                 = {"1", "2", "3"};
+        uint32_t counts[3];
+
+        List_CountMany(list_h, matchers, subs, 3, counts);
+        printf("'1': %d, '2': %d, '3': %d (Count '1': %d)\n",
+               counts[0], counts[1], counts[2], List_Count(list_h, matcher_contains, "1"));
+    }
+
+    printf("\n============> Filter nodes which contains '1'\n");
+    List_Filter(list_h, matcher_contains, "1", batch_free);
+    List_Traverse(list_h, visitor_print_with_arrow, NULL, false);
+
+    printf("\n\n============> Partition nodes which contains '2' into another list\n");
+    List_Partition(list_h, matcher_contains, "2", list_i);
+    List_Traverse(list_h, visitor_print_with_arrow, NULL, false);
+    printf("| ");
+    List_Traverse(list_i, visitor_print_with_arrow, NULL, false);
+    printf("\n");
+
+    List_DestroyList(list_h);
+    List_DestroyList(list_i);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'NaturalSort' 'SortViaArray' 'RadixSort' ======================\n");
+
+    List_t *list_s = List_CreateList(NULL);
+
+    printf("\n============> Push 'node 5', 'node 4', 'node 3', 'node 6', 'node 7', 'node 1' and NaturalSort\n");
+    {
+        const char *names[] = {"node 5", "node 4", "node 3", "node 6", "node 7", "node 1"};
+        for (size_t i = 0; i < 6; i++) {
+            List_Push(list_s, (void *)names[i]);
+        }
+        List_NaturalSort(list_s, comparer);
+        List_Traverse(list_s, visitor_print_with_arrow, NULL, false);
+    }
+
+    printf("\n\n============> Prepend 'node 2' and SortViaArray\n");
+    List_Prepend(list_s, "node 2");
+    printf("sort: %s\n", List_SortViaArray(list_s, comparer, NULL, 0) ? "ok" : "no memory");
+    List_Traverse(list_s, visitor_print_with_arrow, NULL, false);
+
+    printf("\n\n============> Push 'node 32', 'node 17', 'node 0' and RadixSort by the number (32 bits)\n");
+    List_Push(list_s, "node 32");
+    List_Push(list_s, "node 17");
+    List_Push(list_s, "node 0");
+    List_RadixSort(list_s, key_extractor, 32);
+    List_Traverse(list_s, visitor_print_with_arrow, NULL, false);
+
+    printf("\n\n============> RadixSort by the low 4 bits of the number (stable, 32 -> 0, 17 -> 1)\n");
+    List_RadixSort(list_s, key_extractor, 4);
+    List_Traverse(list_s, visitor_print_with_arrow, NULL, false);
+    printf("\n");
+
+    List_DestroyList(list_s);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'PriorityQueue' 'InsertSorted' ======================\n");
+
+    List_t *list_q = List_CreateList(NULL);
+
+    List_CreatePriorityIndex(list_q, comparer);
+
+    printf("\n============> PQInsert 'task 3', 'task 1', 'task 5', 'task 2', 'task 4'\n");
+    {
+        const char *names[] = {"task 3", "task 1", "task 5", "task 2", "task 4"};
+        for (size_t i = 0; i < 5; i++) {
+            List_PQInsert(list_q, (void *)names[i]);
+        }
+        printf("min: '%s'\n", List_GetNodeData(List_PQPeekMin(list_q), char));
+    }
+
+    printf("\n============> PQPopMin all nodes\n");
+    {
+        ListNode_t *node;
+        while ((node = List_PQPopMin(list_q)) != NULL) {
+            printf("'%s' -> ", (char *)node->data);
+            List_FreeNode(list_q, node);
+        }
+    }
+
+    printf("\n\n============> PQInsert 'task 3', 'task 1', 'task 5', change 'task 5' to 'task 0', PQDecreaseKey and PQPopMin all nodes\n");
+    {
+        char names[3][8] = {"task 3", "task 1", "task 5"};
+        ListNode_t *nodes[3], *node;
+        for (size_t i = 0; i < 3; i++) {
+            nodes[i] = List_PQInsert(list_q, names[i]);
+        }
+        names[2][5] = '0';
+        List_PQDecreaseKey(list_q, nodes[2]);
+        while ((node = List_PQPopMin(list_q)) != NULL) {
+            printf("'%s' -> ", (char *)node->data);
+            List_FreeNode(list_q, node);
+        }
+    }
+
+    List_DestroyPriorityIndex(list_q);
+
+    printf("\n\n============> InsertSorted 'task 1', 'task 3', 'task 2', 'task 4', 'task 0'\n");
+    {
+        const char *names[] = {"task 1", "task 3", "task 2", "task 4", "task 0"};
+        for (size_t i = 0; i < 5; i++) {
+            List_InsertSorted(list_q, comparer, (void *)names[i]);
+        }
+        List_Traverse(list_q, visitor_print_with_arrow, NULL, false);
+    }
+    printf("\n");
+
+    List_DestroyList(list_q);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'Intrusive' ======================\n");
+
+    List_t *tasks = List_CreateIntrusiveList(NULL);
+    task_t task_arr[5];
+
+    printf("\n============> Push 5 tasks and remove 'task 2'\n");
+    for (int i = 0; i < 5; i++) {
+        task_arr[i].id = i;
+        List_PushIntrusive(tasks, &task_arr[i].link, &task_arr[i]);
+    }
+    List_RemoveIntrusive(tasks, &task_arr[2].link);
+    {
+        ListNode_t *n;
+        List_Foreach(tasks, n)
+        {
+            printf("'task %d' -> ", List_Entry(n, task_t, link)->id);
+        }
+    }
+    printf("\n");
+
+    List_DestroyList(tasks);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'UnrolledList' ======================\n");
+
+    UList_t *ulist = UList_CreateList(free);
+
+    printf("\n============> Push 40 nodes\n");
+    for (size_t i = 0; i < 40; i++) {
+        char *str = malloc(64);
+        sprintf(str, "node %02d", (int)(40 - i));
+        UList_Push(ulist, str);
+    }
+    UList_Traverse(ulist, visitor_print_with_arrow, NULL, false);
+
+    printf("\n============> Sort\n");
+    UList_Sort(ulist, comparer);
+    UList_Traverse(ulist, visitor_print_with_arrow, NULL, false);
+
+    printf("\n============> Delete nodes which contains '3'\n");
+    UList_DeleteMatched(ulist, matcher_contains, "3");
+    UList_Traverse(ulist, visitor_print_with_arrow, NULL, false);
+
+    printf("\n============> Destroy (len: %d)\n", UList_Length(ulist));
+    UList_DestroyList(ulist);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'MPMCQueue' ======================\n");
+
+    MPMCQueue_t *queue = MPMCQueue_CreateQueue(4);
+
+    printf("\n============> Enqueue 5 nodes (first segment: 4)\n");
+    {
+        const char *names[] = {"node 1", "node 2", "node 3", "node 4", "node 5"};
+        for (size_t i = 0; i < 5; i++) {
+            printf("enqueue '%s': %s\n", names[i], MPMCQueue_Enqueue(queue, (void *)names[i]) ? "ok" : "no memory");
+        }
+        printf("length: %d\n", MPMCQueue_Length(queue));
+    }
+
+    printf("\n============> Dequeue all nodes\n");
+    {
+        void *data;
+        while (MPMCQueue_Dequeue(queue, &data)) {
+            printf("'%s' -> ", (char *)data);
+        }
+    }
+    printf("\n");
+
+    MPMCQueue_DestroyQueue(queue);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'ShardedList' ======================\n");
+
+    ShardedList_t *slist = ShardedList_CreateList(4, NULL);
+
+    printf("\n============> Push 5 nodes (shards: %d)\n", ShardedList_ShardCount(slist));
+    {
+        const char *names[] = {"node 1", "node 2", "node 3", "node 4", "node 5"};
+        for (size_t i = 0; i < 5; i++) {
+            ShardedList_Push(slist, (void *)names[i]);
+        }
+        ShardedList_Traverse(slist, visitor_print_with_arrow, NULL);
+        printf("\nlength: %d\n", ShardedList_Length(slist));
+    }
+
+    printf("\n============> Dequeue all nodes\n");
+    {
+        void *data;
+        while (ShardedList_Dequeue(slist, &data)) {
+            printf("'%s' -> ", (char *)data);
+        }
+    }
+    printf("\n");
+
+    ShardedList_DestroyList(slist);
+
+    ///////////////////////////////////////////////////////////////////////
+
+    printf("\n==================== Test 'SPSCQueue' ======================\n");
+
+    SPSCQueue_t *squeue = SPSCQueue_CreateQueue(2, true);
+
+    printf("\n============> Enqueue 5 nodes (capacity: 2, growable)\n");
+    {
+        const char *names[] = {"node 1", "node 2", "node 3", "node 4", "node 5"};
+        for (size_t i = 0; i < 5; i++) {
+            printf("enqueue '%s': %s\n", names[i], SPSCQueue_Enqueue(squeue, (void *)names[i]) ? "ok" : "full");
+        }
+        printf("length: %d\n", SPSCQueue_Length(squeue));
+    }
+
+    printf("\n============> Dequeue all nodes\n");
+    {
+        void *data;
+        while (SPSCQueue_Dequeue(squeue, &data)) {
+            printf("'%s' -> ", (char *)data);
+        }
+    }
+    printf("\n");
+
+    SPSCQueue_DestroyQueue(squeue);
+
     return 0;
 }
@@ -0,0 +1,60 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#define LIST_THREAD_SAFED
+#define LIST_PARALLEL_SORT
+
+static inline void *_list_mutex_new(void)
+{
+    pthread_mutex_t *mutex = (pthread_mutex_t *)malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+static inline void _list_mutex_free(void *mutex)
+{
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+}
+
+#define List_MutexNew()          _list_mutex_new()
+#define List_MutexFree(mutex)    _list_mutex_free(mutex)
+#define List_MutexAcquire(mutex) pthread_mutex_lock((pthread_mutex_t *)(mutex))
+#define List_MutexRelease(mutex) pthread_mutex_unlock((pthread_mutex_t *)(mutex))
+
+typedef struct {
+    void (*entry)(void *arg);
+    void *arg;
+    pthread_t thread;
+} _list_thread_t;
+
+static void *_list_thread_main(void *thread)
+{
+    _list_thread_t *t = (_list_thread_t *)thread;
+    t->entry(t->arg);
+    return NULL;
+}
+
+static inline void *_list_thread_new(void (*entry)(void *arg), void *arg)
+{
+    _list_thread_t *t = (_list_thread_t *)malloc(sizeof(_list_thread_t));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->entry = entry;
+    t->arg   = arg;
+    if (pthread_create(&t->thread, NULL, _list_thread_main, t) != 0) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+static inline void _list_thread_join(void *thread)
+{
+    pthread_join(((_list_thread_t *)thread)->thread, NULL);
+    free(thread);
+}
+
+#define List_ThreadNew(entry, arg) _list_thread_new(entry, arg)
+#define List_ThreadJoin(thread)    _list_thread_join(thread)
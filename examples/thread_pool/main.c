@@ -0,0 +1,278 @@
+/*
+    MIT License
+
+    Copyright (c) 2020 github0null
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Linked_List.h"
+#include "WS_Deque.h"
+
+//
+// A small thread pool: every worker has its own task queue, it pushes and pops its own tasks (LIFO),
+// when the queue is empty, it steals a task from the other workers (FIFO).
+//
+// The queue is a 'List_t' (List_Push/List_Pop/List_Dequeue under the list mutex)
+// or a 'WSDeque_t' (lock-free), the time of both are printed for different number of workers
+//
+// At last, a large list is sorted by 'List_ParallelSort' with different number of threads
+//
+
+#define MAX_WORKERS 64
+#define TASK_RANGE  (1u << 22)
+#define TASK_GRAIN  64
+#define SORT_NODES  (1u << 19)
+
+typedef struct {
+    uint32_t lo;
+    uint32_t hi;
+} task_t;
+
+typedef struct {
+    List_t *list;
+    WSDeque_t *deque;
+    uint64_t sum;
+    pthread_t thread;
+    uint32_t id;
+} worker_t;
+
+static worker_t workers[MAX_WORKERS];
+static uint32_t worker_count;
+static bool use_deque;
+static atomic_uint pending; // the number of tasks which are not finished
+
+static void push_task(worker_t *worker, task_t *task)
+{
+    if (use_deque) {
+        WSDeque_Push(worker->deque, task);
+    } else {
+        List_Push(worker->list, task);
+    }
+}
+
+static task_t *pop_task(worker_t *worker)
+{
+    void *data = NULL;
+
+    if (use_deque) {
+        WSDeque_Pop(worker->deque, &data);
+    } else {
+        ListNode_t *node = List_Pop(worker->list);
+        if (node != NULL) {
+            data = node->data;
+            List_FreeNode(worker->list, node);
+        }
+    }
+
+    return (task_t *)data;
+}
+
+static task_t *steal_task(worker_t *victim)
+{
+    void *data = NULL;
+
+    if (use_deque) {
+        WSDeque_Steal(victim->deque, &data);
+    } else {
+        ListNode_t *node = List_Dequeue(victim->list);
+        if (node != NULL) {
+            data = node->data;
+            List_FreeNode(victim->list, node);
+        }
+    }
+
+    return (task_t *)data;
+}
+
+static task_t *new_task(uint32_t lo, uint32_t hi)
+{
+    task_t *task = (task_t *)malloc(sizeof(task_t));
+    task->lo     = lo;
+    task->hi     = hi;
+    return task;
+}
+
+static void run_task(worker_t *worker, task_t *task)
+{
+    uint32_t mid, i;
+
+    if (task->hi - task->lo > TASK_GRAIN) {
+        // split the task, the other workers can steal the bigger half
+        mid = task->lo + (task->hi - task->lo) / 2;
+        atomic_fetch_add(&pending, 2);
+        push_task(worker, new_task(mid, task->hi));
+        push_task(worker, new_task(task->lo, mid));
+    } else {
+        for (i = task->lo; i < task->hi; i++) {
+            worker->sum += (uint64_t)i * i % 7;
+        }
+    }
+}
+
+static void *worker_main(void *params)
+{
+    worker_t *worker = (worker_t *)params;
+    task_t *task;
+    uint32_t i;
+
+    while (atomic_load(&pending) > 0) {
+
+        task = pop_task(worker);
+
+        for (i = 1; task == NULL && i < worker_count; i++) {
+            task = steal_task(&workers[(worker->id + i) % worker_count]);
+        }
+
+        if (task == NULL) {
+            sched_yield();
+            continue;
+        }
+
+        run_task(worker, task);
+        free(task);
+        atomic_fetch_sub(&pending, 1);
+    }
+
+    return NULL;
+}
+
+static double run_pool(uint32_t count, bool deque, uint64_t *sum)
+{
+    struct timespec start, end;
+    uint32_t i;
+
+    worker_count = count;
+    use_deque    = deque;
+    *sum         = 0;
+
+    for (i = 0; i < count; i++) {
+        workers[i].id    = i;
+        workers[i].sum   = 0;
+        workers[i].list  = List_CreateList(NULL);
+        workers[i].deque = WSDeque_CreateDeque(256);
+    }
+
+    atomic_store(&pending, 1);
+    push_task(&workers[0], new_task(0, TASK_RANGE));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < count; i++) {
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+
+    for (i = 0; i < count; i++) {
+        pthread_join(workers[i].thread, NULL);
+        *sum += workers[i].sum;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    for (i = 0; i < count; i++) {
+        List_DestroyList(workers[i].list);
+        WSDeque_DestroyDeque(workers[i].deque);
+    }
+
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static int key_comparer(void *d1, void *d2)
+{
+    uintptr_t k1 = (uintptr_t)d1, k2 = (uintptr_t)d2;
+    return k1 < k2 ? -1 : (k1 > k2 ? 1 : 0);
+}
+
+static double run_sort(uint32_t threads, bool *sorted)
+{
+    struct timespec start, end;
+    uint32_t i, seed = 12345;
+    uintptr_t last = 0;
+    ListNode_t *node;
+    List_t *list;
+
+    list = List_CreateList(NULL);
+
+    for (i = 0; i < SORT_NODES; i++) {
+        seed = seed * 1103515245 + 12345;
+        List_Push(list, (void *)(uintptr_t)(seed >> 8));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    List_ParallelSort(list, key_comparer, threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *sorted = List_Length(list) == SORT_NODES;
+
+    List_Foreach(list, node)
+    {
+        if ((uintptr_t)node->data < last) *sorted = false;
+        last = (uintptr_t)node->data;
+    }
+
+    List_DestroyList(list);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+int main(void)
+{
+    uint64_t expect = 0, sum1, sum2;
+    uint32_t cores, count, i;
+    double t1, t2;
+    bool sorted;
+
+    cores = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (i = 0; i < TASK_RANGE; i++) {
+        expect += (uint64_t)i * i % 7;
+    }
+
+    printf("\n==================== Thread Pool (cores: %d, tasks: %d) ======================\n\n",
+           cores, TASK_RANGE / TASK_GRAIN * 2 - 1);
+    printf("workers |  List (mutex) | WSDeque (lock-free)\n");
+
+    for (count = 1; count <= cores * 2 && count <= MAX_WORKERS; count *= 2) {
+
+        t1 = run_pool(count, false, &sum1);
+        t2 = run_pool(count, true, &sum2);
+
+        printf("%7d | %10.2f ms | %10.2f ms %s\n", count, t1, t2,
+               sum1 == expect && sum2 == expect ? "" : "(wrong result !)");
+    }
+
+    printf("\n==================== ParallelSort (cores: %d, nodes: %d) ======================\n\n",
+           cores, SORT_NODES);
+    printf("threads |  ParallelSort\n");
+
+    for (count = 1; count <= cores * 2 && count <= MAX_WORKERS; count *= 2) {
+        t1 = run_sort(count, &sorted);
+        printf("%7d | %10.2f ms %s\n", count, t1, sorted ? "" : "(not sorted !)");
+    }
+
+    return 0;
+}